@@ -0,0 +1,83 @@
+#include "bench_common.h"
+
+#include <sched.h>
+#include <stdlib.h>
+
+void close_start_gate(start_gate& gate)
+{
+	pthread_mutex_lock(&gate.mutex);
+	gate.started = false;
+	gate.aborted = false;
+	pthread_mutex_unlock(&gate.mutex);
+}
+
+void open_start_gate(start_gate& gate, bool aborted)
+{
+	pthread_mutex_lock(&gate.mutex);
+	gate.started = true;
+	gate.aborted = aborted;
+	pthread_cond_broadcast(&gate.cond);
+	pthread_mutex_unlock(&gate.mutex);
+}
+
+bool wait_for_start(start_gate& gate)
+{
+	pthread_mutex_lock(&gate.mutex);
+	while (!gate.started)
+	{
+		pthread_cond_wait(&gate.cond, &gate.mutex);
+	}
+	const bool aborted = gate.aborted;
+	pthread_mutex_unlock(&gate.mutex);
+	return !aborted;
+}
+
+void pin_thread(uint32_t cpu)
+{
+	cpu_set_t cpuset;
+	CPU_ZERO(&cpuset);
+	CPU_SET(cpu, &cpuset);
+	pthread_t thread = pthread_self();
+	pthread_setaffinity_np(thread, sizeof(cpuset), &cpuset);
+}
+
+double get_clockdiff_ms(const struct timespec* start, const struct timespec* end)
+{
+	return ((double)end->tv_nsec/1000000.0 + (double)end->tv_sec*1000.0) -
+			((double)start->tv_nsec/1000000.0 + (double)start->tv_sec*1000.0);
+}
+
+uint64_t round_to_pow_of_two(uint64_t value)
+{
+	uint64_t rounded_value = 1;
+	while (rounded_value < value)
+	{
+		if (rounded_value & 0x8000000000000000ull)
+		{
+			return 0;
+		}
+		rounded_value <<= 1;
+	}
+
+	return value ? rounded_value : 0;
+}
+
+uint64_t get_buffer_size(const char* str_value, uint64_t max_size)
+{
+	const uint64_t value = round_to_pow_of_two(strtoull(str_value, nullptr, 10));
+	return value <= max_size ? value : 0;
+}
+
+uint64_t align_table_buffer_size(uint64_t size)
+{
+	if (!(size & (size - 1)))
+	{
+		return size;
+	}
+	return (size + TABLE_SIZE_ALIGNMENT - 1) / TABLE_SIZE_ALIGNMENT * TABLE_SIZE_ALIGNMENT;
+}
+
+table_reduction get_default_reduction(uint64_t count_of_table_elements)
+{
+	return (count_of_table_elements & (count_of_table_elements - 1)) ? table_reduction::multiply : table_reduction::mask;
+}
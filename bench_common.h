@@ -0,0 +1,87 @@
+#ifndef _BENCH_COMMON_H_
+#define _BENCH_COMMON_H_
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "named_value.h"
+#include "table_format.h"
+#include "table_index.h"
+
+// Definitions shared by fsm_table_access_simd and fsm_bench.
+
+constexpr uint32_t          THREADS_MAX                 = 256;
+constexpr uint32_t          INDICES_BUFFER_SIZE_MAX     = (16 * 1024 * 1024);
+constexpr uint32_t          INDICES_BUFFER_SIZE_DEFAULT = (512 * 1024);
+// Table buffer size is the size of the table with u16 elements, tables in the other
+// formats have the same count of elements.
+constexpr uint32_t          TABLE_ELEMENT_SIZE          = sizeof(uint16_t);
+// Table sizes which are not a power of two are rounded up to whole cache lines.
+constexpr uint64_t          TABLE_SIZE_ALIGNMENT        = 64;
+constexpr const char* const FILE_WITH_INDICES           = "indices.bin";
+
+constexpr named_value<table_format> TABLE_FORMATS[] =
+{
+	{ "u8",  table_format::u8  },
+	{ "u12", table_format::u12 },
+	{ "u16", table_format::u16 },
+	{ "u32", table_format::u32 },
+};
+
+constexpr named_value<table_reduction> TABLE_REDUCTIONS[] =
+{
+	{ "mask",     table_reduction::mask     },
+	{ "multiply", table_reduction::multiply },
+	{ "divide",   table_reduction::divide   },
+};
+
+/** Releases the threads of a run at once after all of them are created.
+ *
+ * Threads wait in wait_for_start() after they are set up, the creator calls
+ * open_start_gate() once it has created all of them or failed to.
+ */
+struct start_gate
+{
+	pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+
+	pthread_cond_t  cond = PTHREAD_COND_INITIALIZER;
+
+	bool            started = false;
+
+	/// Not all threads were created, the created ones return without running.
+	bool            aborted = false;
+};
+
+/// Closes the gate before the threads of the next run are created.
+void close_start_gate(start_gate& gate);
+
+/// Releases the waiting threads, @p aborted tells them to return without running.
+void open_start_gate(start_gate& gate, bool aborted);
+
+/** Waits until the gate is opened.
+ *
+ * @return true if the thread is to run, false if the run was aborted.
+ */
+bool wait_for_start(start_gate& gate);
+
+/// Pins the calling thread to @p cpu.
+void pin_thread(uint32_t cpu);
+
+/// Returns the time from @p start to @p end in ms.
+double get_clockdiff_ms(const struct timespec* start, const struct timespec* end);
+
+/// Rounds up to a power of two, 0 for 0 and for values above 2^63.
+uint64_t round_to_pow_of_two(uint64_t value);
+
+/// Parses a buffer size rounded up to a power of two, 0 if it is invalid or above @p max_size.
+uint64_t get_buffer_size(const char* str_value, uint64_t max_size);
+
+/// Keeps table buffer sizes of a power of two, rounds the other ones up to TABLE_SIZE_ALIGNMENT.
+uint64_t align_table_buffer_size(uint64_t size);
+
+/// Reduction of a table of @p count_of_table_elements elements when none is given.
+table_reduction get_default_reduction(uint64_t count_of_table_elements);
+
+#endif /* end of include guard: _BENCH_COMMON_H_ */
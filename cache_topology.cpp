@@ -0,0 +1,286 @@
+#include "cache_topology.h"
+#include "common.h"
+#include "scope_guard.h"
+
+#include <cpuid.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+constexpr uint32_t CACHE_INDICES_MAX = 16;
+constexpr uint64_t TLB_PAGE_SIZE     = 4096;
+
+// Leaf 2 descriptors of the STLB for 4 KiB pages and their entries.
+constexpr struct
+{
+	uint8_t  descriptor;
+	uint32_t entries;
+} STLB_DESCRIPTORS[] =
+{
+	{ 0xC1, 1024 },
+	{ 0xC3, 1536 },
+	{ 0xCA, 512  },
+};
+
+static int read_line(const char* const path, char* const line, const size_t size)
+{
+	FILE* const file = fopen(path, "r");
+	if (!file)
+	{
+		return -1;
+	}
+	auto close_file = scope_exit([&]() { fclose(file); });
+
+	if (!fgets(line, (int)size, file))
+	{
+		return -1;
+	}
+	line[strcspn(line, "\n")] = '\0';
+	return 0;
+}
+
+static uint64_t read_number(const char* const path)
+{
+	char line[64];
+	if (read_line(path, line, sizeof(line)) < 0)
+	{
+		return 0;
+	}
+	// Sizes look like "48K".
+	char*          end = nullptr;
+	const uint64_t value = strtoull(line, &end, 10);
+	switch (*end)
+	{
+		case 'K':
+			return value << 10;
+
+		case 'M':
+			return value << 20;
+
+		case 'G':
+			return value << 30;
+	}
+	return value;
+}
+
+/** Reads a list of CPUs like "0-3,8-11,16".
+ *
+ * @param first Output for the lowest CPU of the list.
+ * @param cpus  Optional output flags of the CPUs of the list.
+ *
+ * @return Count of CPUs of the list, 0 on failure.
+ */
+static uint32_t read_cpu_list(const char* const path, uint32_t& first, bool* const cpus = nullptr)
+{
+	char line[4096];
+	if (read_line(path, line, sizeof(line)) < 0)
+	{
+		return 0;
+	}
+	uint32_t    count = 0;
+	const char* str = line;
+	first = UINT32_MAX;
+	while (*str >= '0' && *str <= '9')
+	{
+		char*          end = nullptr;
+		const uint32_t low = (uint32_t)strtoul(str, &end, 10);
+		uint32_t       high = low;
+		if (*end == '-')
+		{
+			high = (uint32_t)strtoul(end + 1, &end, 10);
+		}
+		for (uint32_t cpu = low; cpus && cpu <= high && cpu < CACHE_CPUS_MAX; ++cpu)
+		{
+			cpus[cpu] = true;
+		}
+		first = std::min(first, low);
+		count += high - low + 1;
+		str = (*end == ',') ? end + 1 : end;
+	}
+	return count;
+}
+
+static uint32_t get_stlb_entries()
+{
+	uint32_t eax;
+	uint32_t ebx;
+	uint32_t ecx;
+	uint32_t edx;
+	uint32_t entries = 0;
+
+	const uint32_t leaf_max = __get_cpuid_max(0, nullptr);
+	if (leaf_max >= 0x18)
+	{
+		__cpuid_count(0x18, 0, eax, ebx, ecx, edx);
+		const uint32_t subleaf_max = eax;
+		for (uint32_t subleaf = 0; subleaf <= subleaf_max; ++subleaf)
+		{
+			__cpuid_count(0x18, subleaf, eax, ebx, ecx, edx);
+			const uint32_t type = edx & 0x1F;
+			const uint32_t level = (edx >> 5) & 0x7;
+			// Data or unified TLB of the second level with 4 KiB pages, entries are ways times sets.
+			if (level == 2 && (type == 1 || type == 3) && (ebx & 1))
+			{
+				entries = std::max(entries, (ebx >> 16) * ecx);
+			}
+		}
+	}
+	if (!entries && leaf_max >= 2)
+	{
+		__cpuid(2, eax, ebx, ecx, edx);
+		const uint32_t registers[] = {eax & ~0xFFu, ebx, ecx, edx};
+		for (const uint32_t reg : registers)
+		{
+			// Registers with the highest bit set hold no descriptors.
+			for (uint32_t byte = 0; byte < 4 && !(reg >> 31); ++byte)
+			{
+				const uint8_t descriptor = (uint8_t)(reg >> (byte * 8));
+				for (const auto& stlb : STLB_DESCRIPTORS)
+				{
+					if (stlb.descriptor == descriptor)
+					{
+						entries = std::max(entries, stlb.entries);
+					}
+				}
+			}
+		}
+	}
+	if (!entries && __get_cpuid(0x80000006, &eax, &ebx, &ecx, &edx))
+	{
+		// L2 data TLB of AMD for 4 KiB pages.
+		entries = (ebx >> 16) & 0xFFF;
+	}
+	return entries;
+}
+
+int detect_cache_topology(cache_topology& topology)
+{
+	topology = cache_topology();
+
+	uint32_t first = 0;
+	topology.threads_per_core = std::max(read_cpu_list("/sys/devices/system/cpu/cpu0/topology/thread_siblings_list", first), 1u);
+
+	bool online[CACHE_CPUS_MAX] = {};
+	if (!read_cpu_list("/sys/devices/system/cpu/online", first, online))
+	{
+		online[0] = true;
+	}
+
+	char line[64];
+	for (uint32_t index = 0; index < CACHE_INDICES_MAX && topology.level_count < CACHE_LEVELS_MAX; ++index)
+	{
+		char path[256];
+		snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%u/type", index);
+		if (read_line(path, line, sizeof(line)) < 0)
+		{
+			break;
+		}
+		if (strcmp(line, "Data") != 0 && strcmp(line, "Unified") != 0)
+		{
+			continue;
+		}
+
+		cache_level& cache = topology.levels[topology.level_count];
+		snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%u/level", index);
+		cache.level = (uint32_t)read_number(path);
+		snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%u/size", index);
+		cache.size = read_number(path);
+		snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%u/coherency_line_size", index);
+		cache.line_size = (uint32_t)read_number(path);
+		snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%u/ways_of_associativity", index);
+		cache.ways = (uint32_t)read_number(path);
+		snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%u/shared_cpu_list", index);
+		cache.shared_cpu_count = std::max(read_cpu_list(path, first), 1u);
+		if (!cache.level || !cache.size)
+		{
+			continue;
+		}
+
+		// Each instance is counted by the lowest CPU sharing it.
+		for (uint32_t cpu = 0; cpu < CACHE_CPUS_MAX; ++cpu)
+		{
+			snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/cache/index%u/shared_cpu_list", cpu, index);
+			if (online[cpu] && read_cpu_list(path, first) && first == cpu)
+			{
+				cache.instance_count++;
+			}
+		}
+		cache.instance_count = std::max(cache.instance_count, 1u);
+		topology.level_count++;
+	}
+	std::sort(topology.levels, topology.levels + topology.level_count,
+			[](const cache_level& a, const cache_level& b) { return a.level < b.level; });
+
+	topology.stlb_entries = get_stlb_entries();
+
+	return topology.level_count ? 0 : -1;
+}
+
+static void add_boundary(cache_boundary* boundaries, uint32_t& count, const uint32_t boundaries_max, const char* name, uint64_t size, boundary_kind kind)
+{
+	if (count < boundaries_max && size)
+	{
+		cache_boundary& boundary = boundaries[count++];
+		snprintf(boundary.name, sizeof(boundary.name), "%s", name);
+		boundary.size = size;
+		boundary.kind = kind;
+	}
+}
+
+uint32_t get_cache_boundaries(const cache_topology& topology, cache_boundary* boundaries, uint32_t boundaries_max)
+{
+	uint32_t count = 0;
+	char     name[16];
+	for (uint32_t i = 0; i < topology.level_count; ++i)
+	{
+		const cache_level& cache = topology.levels[i];
+		snprintf(name, sizeof(name), "L%u%s", cache.level, cache.level == 1 ? "d" : "");
+		add_boundary(boundaries, count, boundaries_max, name, cache.size, boundary_kind::cache);
+
+		const uint32_t core_count = std::max(cache.shared_cpu_count / topology.threads_per_core, 1u);
+		if (i + 1 == topology.level_count && core_count > 1)
+		{
+			snprintf(name, sizeof(name), "L%uslice", cache.level);
+			add_boundary(boundaries, count, boundaries_max, name, cache.size / core_count, boundary_kind::slice);
+		}
+		if (i + 1 == topology.level_count && cache.instance_count > 1)
+		{
+			snprintf(name, sizeof(name), "L%utotal", cache.level);
+			add_boundary(boundaries, count, boundaries_max, name, cache.size * cache.instance_count, boundary_kind::cache);
+		}
+	}
+	add_boundary(boundaries, count, boundaries_max, "STLB", topology.stlb_entries * TLB_PAGE_SIZE, boundary_kind::tlb);
+
+	std::stable_sort(boundaries, boundaries + count,
+			[](const cache_boundary& a, const cache_boundary& b) { return a.size < b.size; });
+	return count;
+}
+
+const cache_boundary* find_cache_boundary(const cache_boundary* boundaries, uint32_t count, uint64_t size, boundary_kind kind)
+{
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		if (boundaries[i].kind == kind && size <= boundaries[i].size)
+		{
+			return &boundaries[i];
+		}
+	}
+	return nullptr;
+}
+
+void format_cache_boundaries(const cache_boundary* boundaries, uint32_t count, char* buf, size_t size)
+{
+	size_t offset = 0;
+	buf[0] = '\0';
+	for (uint32_t i = 0; i < count && offset < size; ++i)
+	{
+		const int written = snprintf(buf + offset, size - offset, "%s%s %" PRIu64 " kB",
+				offset ? ", " : "", boundaries[i].name, boundaries[i].size >> 10);
+		if (written > 0)
+		{
+			offset += written;
+		}
+	}
+}
@@ -0,0 +1,102 @@
+#ifndef _CACHE_TOPOLOGY_H_
+#define _CACHE_TOPOLOGY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+constexpr uint32_t CACHE_LEVELS_MAX     = 4;
+constexpr uint32_t CACHE_BOUNDARIES_MAX = 2 * CACHE_LEVELS_MAX + 1;
+constexpr uint32_t CACHE_CPUS_MAX       = 1024;
+
+/// Data or unified cache of one level, as seen by CPU 0.
+struct cache_level
+{
+	/// 1 for L1d, 2 for L2 and so on.
+	uint32_t level = 0;
+
+	/// Count of bytes of one instance of the cache.
+	uint64_t size = 0;
+
+	uint32_t line_size = 0;
+
+	uint32_t ways = 0;
+
+	/// Count of CPUs sharing one instance, hardware threads included.
+	uint32_t shared_cpu_count = 0;
+
+	/// Count of instances of the cache over the online CPUs.
+	uint32_t instance_count = 0;
+};
+
+struct cache_topology
+{
+	/// Caches ordered by level.
+	cache_level levels[CACHE_LEVELS_MAX] = {};
+
+	uint32_t    level_count = 0;
+
+	/// Count of hardware threads of a core.
+	uint32_t    threads_per_core = 1;
+
+	/// Entries of the second level TLB for 4 KiB data pages, 0 if cpuid does not report them.
+	uint32_t    stlb_entries = 0;
+};
+
+/// What limits the size of the tables at a cache_boundary.
+enum class boundary_kind : uint32_t
+{
+	/// Capacity of a cache.
+	cache,
+	/// Capacity of a slice of a cache, the lines are spread over all slices.
+	slice,
+	/// Reach of the TLB.
+	tlb,
+};
+
+/// Largest table which fits in a part of the memory hierarchy.
+struct cache_boundary
+{
+	char          name[16];
+
+	/// Count of bytes of the table.
+	uint64_t      size;
+
+	boundary_kind kind;
+};
+
+/** Reads the caches from /sys/devices/system/cpu/cpuN/cache and the TLB from cpuid.
+ *
+ * The STLB is read from the deterministic address translation parameters
+ * (leaf 0x18), the descriptors of leaf 2 or the AMD leaf 0x80000006,
+ * whichever the CPU reports.
+ *
+ * @return 0 on success, -1 if no caches are reported.
+ */
+int detect_cache_topology(cache_topology& topology);
+
+/** Lists the boundaries of the hierarchy ordered by size.
+ *
+ * Each cache level gives a boundary at its size. The last level shared by
+ * several cores gives also its per core slice, and the sum of its instances
+ * when there are more of them. The STLB gives its reach with 4 KiB pages.
+ *
+ * @return Count of the boundaries written to @p boundaries.
+ */
+uint32_t get_cache_boundaries(const cache_topology& topology, cache_boundary* boundaries, uint32_t boundaries_max);
+
+/** Returns the smallest boundary a table of @p size bytes fits in.
+ *
+ * @param kind Kind of the boundaries to look at.
+ *
+ * @return The boundary or nullptr if the table does not fit.
+ */
+const cache_boundary* find_cache_boundary(const cache_boundary* boundaries, uint32_t count, uint64_t size, boundary_kind kind);
+
+/** Formats the boundaries as a space separated list of names and sizes.
+ *
+ * @param buf  Output buffer.
+ * @param size Size of the output buffer.
+ */
+void format_cache_boundaries(const cache_boundary* boundaries, uint32_t count, char* buf, size_t size);
+
+#endif /* end of include guard: _CACHE_TOPOLOGY_H_ */
@@ -0,0 +1,17 @@
+#ifndef _COMMON_H_
+#define _COMMON_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+/// Stream of INFO messages, moved to stderr when stdout carries structured results.
+inline FILE* info_stream = stdout;
+
+#define INFO(fmt, ...) fprintf(info_stream, "I " fmt, ##__VA_ARGS__)
+#define ERR(fmt, ...) fprintf(stderr, "E " fmt, ##__VA_ARGS__)
+
+constexpr uint16_t          TABLE_XOR_VAL               = 26849;
+constexpr uint16_t          TABLE_ADD_VAL               = 41387;
+constexpr uint32_t          INDEX_XOR_VAL               = (TABLE_XOR_VAL << 16) | TABLE_ADD_VAL;
+
+#endif /* end of include guard: _COMMON_H_ */
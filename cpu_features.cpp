@@ -0,0 +1,94 @@
+#include "cpu_features.h"
+
+#include <cpuid.h>
+#include <stdio.h>
+
+// XCR0 bits of the register state the OS has to save.
+constexpr uint64_t XCR0_SSE       = 1 << 1;
+constexpr uint64_t XCR0_AVX       = 1 << 2;
+constexpr uint64_t XCR0_OPMASK    = 1 << 5;
+constexpr uint64_t XCR0_ZMM_HI256 = 1 << 6;
+constexpr uint64_t XCR0_HI16_ZMM  = 1 << 7;
+constexpr uint64_t XCR0_AVX_STATE    = XCR0_SSE | XCR0_AVX;
+constexpr uint64_t XCR0_AVX512_STATE = XCR0_AVX_STATE | XCR0_OPMASK | XCR0_ZMM_HI256 | XCR0_HI16_ZMM;
+
+static uint64_t read_xcr0()
+{
+	uint32_t eax;
+	uint32_t edx;
+	// xgetbv is emitted directly, the intrinsic needs -mxsave.
+	__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return ((uint64_t)edx << 32) | eax;
+}
+
+uint32_t detect_cpu_features()
+{
+	uint32_t eax;
+	uint32_t ebx;
+	uint32_t ecx;
+	uint32_t edx;
+	uint32_t features = 0;
+
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+	{
+		return 0;
+	}
+	if (ecx & bit_SSE4_1)
+	{
+		features |= CPU_FEATURE_SSE41;
+	}
+	if (ecx & bit_SSE4_2)
+	{
+		features |= CPU_FEATURE_SSE42;
+	}
+	const uint64_t xcr0 = (ecx & bit_OSXSAVE) ? read_xcr0() : 0;
+
+	if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+	{
+		return features;
+	}
+	if ((ebx & bit_AVX2) && (xcr0 & XCR0_AVX_STATE) == XCR0_AVX_STATE)
+	{
+		features |= CPU_FEATURE_AVX2;
+	}
+	if ((ebx & bit_AVX512F) && (xcr0 & XCR0_AVX512_STATE) == XCR0_AVX512_STATE)
+	{
+		features |= CPU_FEATURE_AVX512F;
+	}
+	if (ebx & bit_BMI2)
+	{
+		features |= CPU_FEATURE_BMI2;
+	}
+
+	return features;
+}
+
+void format_cpu_features(uint32_t features, char* buf, size_t size)
+{
+	static const struct
+	{
+		cpu_feature feature;
+		const char* name;
+	} names[] =
+	{
+		{ CPU_FEATURE_SSE41,   "sse4.1"  },
+		{ CPU_FEATURE_SSE42,   "sse4.2"  },
+		{ CPU_FEATURE_AVX2,    "avx2"    },
+		{ CPU_FEATURE_AVX512F, "avx512f" },
+		{ CPU_FEATURE_BMI2,    "bmi2"    },
+	};
+
+	size_t offset = 0;
+	buf[0] = '\0';
+	for (const auto& entry : names)
+	{
+		if ((features & entry.feature) && offset < size)
+		{
+			const int written = snprintf(buf + offset, size - offset, "%s%s", offset ? " " : "", entry.name);
+			if (written > 0)
+			{
+				offset += written;
+			}
+		}
+	}
+}
@@ -0,0 +1,34 @@
+#ifndef _CPU_FEATURES_H_
+#define _CPU_FEATURES_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// Instruction set extensions the kernels and other code may depend on.
+enum cpu_feature : uint32_t
+{
+	CPU_FEATURE_SSE41   = 1 << 0,
+	CPU_FEATURE_AVX2    = 1 << 1,
+	CPU_FEATURE_AVX512F = 1 << 2,
+	CPU_FEATURE_BMI2    = 1 << 3,
+	CPU_FEATURE_SSE42   = 1 << 4,
+};
+
+/** Detects features of the CPU we are running on using cpuid.
+ *
+ * AVX2 and AVX-512F are reported only if the OS saves the corresponding
+ * register state (checked using xgetbv).
+ *
+ * @return Mask of cpu_feature values.
+ */
+uint32_t detect_cpu_features();
+
+/** Formats the feature mask as a space separated list of names.
+ *
+ * @param features Mask of cpu_feature values.
+ * @param buf      Output buffer.
+ * @param size     Size of the output buffer.
+ */
+void format_cpu_features(uint32_t features, char* buf, size_t size);
+
+#endif /* end of include guard: _CPU_FEATURES_H_ */
@@ -0,0 +1,43 @@
+#include "crc32c.h"
+#include "cpu_features.h"
+
+// Reflected polynomial of CRC32C.
+constexpr uint32_t CRC32C_POLYNOMIAL = 0x82F63B78;
+
+struct crc32c_table
+{
+	uint32_t entries[256];
+
+	constexpr crc32c_table()
+		: entries()
+	{
+		for (uint32_t byte = 0; byte < 256; ++byte)
+		{
+			uint32_t crc = byte;
+			for (uint32_t bit = 0; bit < 8; ++bit)
+			{
+				crc = (crc >> 1) ^ ((crc & 1) ? CRC32C_POLYNOMIAL : 0);
+			}
+			entries[byte] = crc;
+		}
+	}
+};
+
+constexpr crc32c_table CRC32C_TABLE;
+
+static uint32_t crc32c_table_driven(uint32_t crc, const void* data, size_t size)
+{
+	const uint8_t* bytes = (const uint8_t*)data;
+	crc = ~crc;
+	for (size_t i = 0; i < size; ++i)
+	{
+		crc = CRC32C_TABLE.entries[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+	}
+	return ~crc;
+}
+
+uint32_t crc32c(uint32_t crc, const void* data, size_t size)
+{
+	static const bool has_sse42 = (detect_cpu_features() & CPU_FEATURE_SSE42) != 0;
+	return has_sse42 ? crc32c_sse42(crc, data, size) : crc32c_table_driven(crc, data, size);
+}
@@ -0,0 +1,22 @@
+#ifndef _CRC32C_H_
+#define _CRC32C_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** Updates CRC32C (Castagnoli) of a byte sequence.
+ *
+ * Uses the crc32 instruction of SSE4.2 when the CPU has it.
+ *
+ * @param crc  CRC32C of the preceding bytes, 0 for the first call.
+ * @param data Next bytes.
+ * @param size Count of the bytes.
+ *
+ * @return CRC32C of all bytes so far.
+ */
+uint32_t crc32c(uint32_t crc, const void* data, size_t size);
+
+/// Implementation of crc32c() by the crc32 instruction, the CPU has to support SSE4.2.
+uint32_t crc32c_sse42(uint32_t crc, const void* data, size_t size);
+
+#endif /* end of include guard: _CRC32C_H_ */
@@ -0,0 +1,21 @@
+#include "crc32c.h"
+
+#include <nmmintrin.h>
+#include <string.h>
+
+uint32_t crc32c_sse42(uint32_t crc, const void* data, size_t size)
+{
+	const uint8_t* bytes = (const uint8_t*)data;
+	uint64_t       value = ~crc;
+	for (; size >= sizeof(uint64_t); size -= sizeof(uint64_t), bytes += sizeof(uint64_t))
+	{
+		uint64_t word;
+		memcpy(&word, bytes, sizeof(word));
+		value = _mm_crc32_u64(value, word);
+	}
+	for (; size; --size, ++bytes)
+	{
+		value = _mm_crc32_u8((uint32_t)value, *bytes);
+	}
+	return ~(uint32_t)value;
+}
@@ -0,0 +1,198 @@
+#include "file_header.h"
+#include "common.h"
+#include "crc32c.h"
+#include "scope_guard.h"
+
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+static uint32_t get_header_crc(const file_header& header)
+{
+	file_header copy = header;
+	copy.header_crc = 0;
+	return crc32c(0, &copy, sizeof(copy));
+}
+
+static uint64_t get_payload_size(uint32_t element_bits, uint64_t element_count)
+{
+	return (element_count * element_bits + 7) / 8;
+}
+
+int get_data_file_path(char* path, size_t size, const char* location, const char* filename)
+{
+	const int length = snprintf(path, size, "%s/%s", location, filename);
+	if (length < 0 || (size_t)length >= size)
+	{
+		ERR("path %s/%s too long\n", location, filename);
+		return -1;
+	}
+	return 0;
+}
+
+int read_file_header(int fd, const char* path, file_payload& payload)
+{
+	struct stat statbuf;
+	if (fstat(fd, &statbuf) < 0)
+	{
+		ERR("fstat(%s) failed\n", path);
+		return -1;
+	}
+	const uint64_t file_size = statbuf.st_size;
+
+	payload = file_payload();
+	payload.size = file_size;
+	file_header& header = payload.header;
+	if (file_size < sizeof(header) ||
+		pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+		memcmp(header.magic, FILE_HEADER_MAGIC, sizeof(FILE_HEADER_MAGIC)) != 0)
+	{
+		// Legacy raw file.
+		header = file_header();
+		return 0;
+	}
+
+	if (header.version != FILE_HEADER_VERSION)
+	{
+		ERR("%s has unsupported version %u of the header\n", path, header.version);
+		return -1;
+	}
+	if (header.header_crc != get_header_crc(header))
+	{
+		ERR("%s has corrupted header\n", path);
+		return -1;
+	}
+	if (header.alignment < sizeof(header) || (header.alignment & (header.alignment - 1)) ||
+		header.payload_size != get_payload_size(header.element_bits, header.element_count) ||
+		header.alignment + header.payload_size > file_size)
+	{
+		ERR("%s has inconsistent header: alignment %u, %" PRIu64 " elements of %u bits, payload %" PRIu64 " bytes, file %" PRIu64 " bytes\n",
+				path, header.alignment, header.element_count, header.element_bits, header.payload_size, file_size);
+		return -1;
+	}
+
+	payload.offset = header.alignment;
+	payload.size = header.payload_size;
+	payload.has_header = true;
+	return 0;
+}
+
+int read_file_header(const char* path, file_payload& payload)
+{
+	const int fd = open(path, O_RDONLY);
+	if (fd < 0)
+	{
+		ERR("open(%s) failed\n", path);
+		return -1;
+	}
+	auto close_fd = scope_exit([&]() { close(fd); });
+	return read_file_header(fd, path, payload);
+}
+
+void init_file_header(
+		file_header& header,
+		file_content content,
+		uint32_t     element_bits,
+		uint64_t     element_count,
+		uint32_t     alphabet_size,
+		const void*  payload,
+		size_t       size)
+{
+	header = file_header();
+	memcpy(header.magic, FILE_HEADER_MAGIC, sizeof(FILE_HEADER_MAGIC));
+	header.version = FILE_HEADER_VERSION;
+	header.content = content;
+	header.element_bits = element_bits;
+	header.layout = element_bits == 12 ? file_layout::packed_pairs : file_layout::linear;
+	header.alignment = FILE_PAYLOAD_ALIGNMENT;
+	header.element_count = element_count;
+	header.payload_size = size;
+	header.state_count = alphabet_size ? (uint32_t)(element_count / alphabet_size) : 0;
+	header.alphabet_size = alphabet_size;
+	header.payload_crc = crc32c(0, payload, size);
+	header.header_crc = get_header_crc(header);
+}
+
+int check_file_header(const file_payload& payload, const char* path, file_content content, uint32_t element_bits)
+{
+	if (!payload.has_header)
+	{
+		return 0;
+	}
+	if (payload.header.content != content)
+	{
+		ERR("%s holds %s, expected %s\n", path,
+				payload.header.content == file_content::table ? "a table" : "indices",
+				content == file_content::table ? "a table" : "indices");
+		return -1;
+	}
+	if (payload.header.element_bits != element_bits)
+	{
+		ERR("%s has %u-bit elements, expected %u bits\n", path, payload.header.element_bits, element_bits);
+		return -1;
+	}
+	return 0;
+}
+
+int get_header_table_format(const file_header& header, table_format& format)
+{
+	static const table_format formats[] = {table_format::u8, table_format::u12, table_format::u16, table_format::u32};
+	for (const table_format candidate : formats)
+	{
+		if (get_table_element_bits(candidate) == header.element_bits)
+		{
+			format = candidate;
+			return 0;
+		}
+	}
+	return -1;
+}
+
+int verify_payload_crc(const file_payload& payload, const char* path, const void* data, size_t size)
+{
+	if (!payload.has_header)
+	{
+		return 0;
+	}
+	if (size != payload.size)
+	{
+		INFO("%zu of %" PRIu64 " bytes of %s loaded, CRC32C not verified\n", size, payload.size, path);
+		return 0;
+	}
+	const uint32_t crc = crc32c(0, data, size);
+	if (crc != payload.header.payload_crc)
+	{
+		ERR("%s has corrupted payload: CRC32C %08x, expected %08x\n", path, crc, payload.header.payload_crc);
+		return -1;
+	}
+	return 0;
+}
+
+int write_data_file(const char* path, const file_header& header, const void* data, size_t size)
+{
+	FILE* const file = fopen(path, "wb");
+	if (!file)
+	{
+		ERR("fopen(%s) failed\n", path);
+		return -1;
+	}
+	static const char zeros[4096] = {};
+	const size_t      padding = header.alignment - sizeof(header);
+	bool              written = fwrite(&header, sizeof(header), 1, file) == 1;
+	for (size_t left = padding; written && left; )
+	{
+		const size_t count = left < sizeof(zeros) ? left : sizeof(zeros);
+		written = fwrite(zeros, 1, count, file) == count;
+		left -= count;
+	}
+	written = written && fwrite(data, 1, size, file) == size;
+	if (fclose(file) != 0 || !written)
+	{
+		ERR("write of %s failed\n", path);
+		return -1;
+	}
+	return 0;
+}
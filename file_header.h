@@ -0,0 +1,172 @@
+#ifndef _FILE_HEADER_H_
+#define _FILE_HEADER_H_
+
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "table_format.h"
+
+constexpr char     FILE_HEADER_MAGIC[8]   = {'F', 'S', 'M', 'D', 'A', 'T', 'A', '\0'};
+constexpr uint32_t FILE_HEADER_VERSION    = 1;
+/// Offset of the payload in the file, so the payload can be mapped by mmap() with 2 MiB huge pages.
+constexpr uint32_t FILE_PAYLOAD_ALIGNMENT = 2 * 1024 * 1024;
+/// Size of buffers for paths of data files.
+constexpr size_t   FILE_PATH_MAX          = PATH_MAX;
+
+/// What the payload of a data file holds.
+enum class file_content : uint32_t
+{
+	table = 1,
+	indices = 2,
+};
+
+/// Arrangement of the elements in the payload.
+enum class file_layout : uint32_t
+{
+	/// Each element in its own little endian word of element_bits.
+	linear,
+	/// 12-bit elements packed by pairs to 3 bytes, little endian.
+	packed_pairs,
+};
+
+/** Header at the beginning of table and indices files.
+ *
+ * Files without the magic are legacy raw files, their whole contents is the
+ * payload. All fields are little endian.
+ */
+struct file_header
+{
+	char         magic[8];
+
+	uint32_t     version;
+
+	/// CRC32C of the header with this field zeroed.
+	uint32_t     header_crc;
+
+	file_content content;
+
+	/// Count of bits of an element.
+	uint32_t     element_bits;
+
+	file_layout  layout;
+
+	/// Offset of the payload in the file, a power of two.
+	uint32_t     alignment;
+
+	uint64_t     element_count;
+
+	/// Count of bytes of the payload.
+	uint64_t     payload_size;
+
+	/// Count of states of the DFA walked in the table, 0 for indices.
+	uint32_t     state_count;
+
+	/// Count of symbols per state of the table, 0 for indices.
+	uint32_t     alphabet_size;
+
+	/// CRC32C of the payload.
+	uint32_t     payload_crc;
+
+	uint32_t     reserved;
+};
+
+static_assert(sizeof(file_header) == 64, "file_header is a part of the file format");
+
+/// Location of the payload in a data file.
+struct file_payload
+{
+	/// Offset of the payload in the file.
+	uint64_t    offset = 0;
+
+	/// Count of bytes of the payload.
+	uint64_t    size = 0;
+
+	/// Whether the file has a header, legacy files do not.
+	bool        has_header = false;
+
+	file_header header = {};
+};
+
+/** Joins the directory and the name of a data file.
+ *
+ * @param path     Output buffer.
+ * @param size     Size of the output buffer.
+ * @param location Directory with the file.
+ * @param filename Name of the file.
+ *
+ * @return 0 on success, -1 if the path does not fit the buffer.
+ */
+int get_data_file_path(char* path, size_t size, const char* location, const char* filename);
+
+/** Reads and validates the header of an open data file.
+ *
+ * @param fd      Open file.
+ * @param path    Path to the file for messages.
+ * @param payload Output with the location of the payload, the whole file for
+ *                legacy files.
+ *
+ * @return 0 on success, -1 on failure or invalid header.
+ */
+int read_file_header(int fd, const char* path, file_payload& payload);
+
+/** Reads and validates the header of a data file.
+ *
+ * @return 0 on success, -1 on failure or invalid header.
+ */
+int read_file_header(const char* path, file_payload& payload);
+
+/** Fills a header describing a payload.
+ *
+ * @param header        Output header.
+ * @param content       What the payload holds.
+ * @param element_bits  Count of bits of an element, 12-bit elements are packed by pairs.
+ * @param element_count Count of elements.
+ * @param alphabet_size Count of symbols per state of a table, 0 for indices.
+ * @param payload       Payload, used for its CRC32C.
+ * @param size          Count of bytes of the payload.
+ */
+void init_file_header(
+		file_header& header,
+		file_content content,
+		uint32_t     element_bits,
+		uint64_t     element_count,
+		uint32_t     alphabet_size,
+		const void*  payload,
+		size_t       size);
+
+/** Checks that a data file holds what the caller expects.
+ *
+ * Legacy files pass, there is nothing to check.
+ *
+ * @param element_bits Expected count of bits of an element.
+ *
+ * @return 0 on success, -1 on mismatch.
+ */
+int check_file_header(const file_payload& payload, const char* path, file_content content, uint32_t element_bits);
+
+/** Returns the table format of the elements described by @p header.
+ *
+ * @return 0 on success, -1 if no format has the elements.
+ */
+int get_header_table_format(const file_header& header, table_format& format);
+
+/** Compares CRC32C of a loaded payload to the header.
+ *
+ * Only payloads loaded whole can be verified, for a part of the payload or a
+ * legacy file nothing is checked.
+ *
+ * @param data Loaded bytes from the beginning of the payload.
+ * @param size Count of the loaded bytes.
+ *
+ * @return 0 on success, -1 on mismatch.
+ */
+int verify_payload_crc(const file_payload& payload, const char* path, const void* data, size_t size);
+
+/** Writes a data file with a header, the payload starts at header.alignment.
+ *
+ * @return 0 on success, -1 on failure.
+ */
+int write_data_file(const char* path, const file_header& header, const void* data, size_t size);
+
+#endif /* end of include guard: _FILE_HEADER_H_ */
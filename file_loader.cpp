@@ -0,0 +1,399 @@
+#include "file_loader.h"
+#include "common.h"
+#include "scope_guard.h"
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+
+static size_t round_up(size_t value, size_t alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+/// Minimal io_uring driven by the raw system calls, liburing is not required.
+class uring
+{
+public:
+	uring() = default;
+
+	~uring();
+
+	/** Creates the ring with @p entries submission entries.
+	 *
+	 * @return 0 on success, -1 if io_uring or its read operation is not available.
+	 */
+	int open(uint32_t entries);
+
+	/// Queues a read, submitted by the next enter().
+	void queue_read(int file, void* data, uint32_t length, uint64_t offset, uint64_t user_data);
+
+	/** Submits the queued entries and waits for at least @p min_complete completions.
+	 *
+	 * @return 0 on success, -1 on failure.
+	 */
+	int enter(uint32_t min_complete);
+
+	/// Takes the next completion, returns false if there is none.
+	bool reap(io_uring_cqe& cqe);
+
+private:
+	int            fd = -1;
+
+	void*          sq_ring = MAP_FAILED;
+	size_t         sq_ring_size = 0;
+	void*          cq_ring = MAP_FAILED;
+	size_t         cq_ring_size = 0;
+	io_uring_sqe*  sqes = (io_uring_sqe*)MAP_FAILED;
+	size_t         sqes_size = 0;
+
+	uint32_t*      sq_tail = nullptr;
+	uint32_t*      sq_mask = nullptr;
+	uint32_t*      sq_array = nullptr;
+	uint32_t*      cq_head = nullptr;
+	uint32_t*      cq_tail = nullptr;
+	uint32_t*      cq_mask = nullptr;
+	io_uring_cqe*  cqes = nullptr;
+
+	/// Entries queued since the last enter().
+	uint32_t       queued = 0;
+
+	// No copying.
+	uring( const uring& )            = delete;
+	uring& operator=( const uring& ) = delete;
+};
+
+uring::~uring()
+{
+	if (sqes != MAP_FAILED)
+	{
+		munmap(sqes, sqes_size);
+	}
+	if (cq_ring != MAP_FAILED && cq_ring != sq_ring)
+	{
+		munmap(cq_ring, cq_ring_size);
+	}
+	if (sq_ring != MAP_FAILED)
+	{
+		munmap(sq_ring, sq_ring_size);
+	}
+	if (fd >= 0)
+	{
+		close(fd);
+	}
+}
+
+int uring::open(uint32_t entries)
+{
+	io_uring_params params;
+	memset(&params, 0, sizeof(params));
+	fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+	if (fd < 0)
+	{
+		return -1;
+	}
+
+	// IORING_OP_READ is there since 5.6, just like the probe.
+	constexpr uint32_t probe_ops = 256;
+	uint8_t            probe_storage[sizeof(io_uring_probe) + probe_ops * sizeof(io_uring_probe_op)] = {};
+	io_uring_probe*    probe = (io_uring_probe*)probe_storage;
+	if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, probe_ops) < 0 ||
+		probe->last_op < IORING_OP_READ ||
+		!(probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED))
+	{
+		return -1;
+	}
+
+	sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+	cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	if (params.features & IORING_FEAT_SINGLE_MMAP)
+	{
+		sq_ring_size = std::max(sq_ring_size, cq_ring_size);
+		cq_ring_size = sq_ring_size;
+	}
+	sq_ring = mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+	if (sq_ring == MAP_FAILED)
+	{
+		return -1;
+	}
+	if (params.features & IORING_FEAT_SINGLE_MMAP)
+	{
+		cq_ring = sq_ring;
+	}
+	else
+	{
+		cq_ring = mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+		if (cq_ring == MAP_FAILED)
+		{
+			return -1;
+		}
+	}
+	sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+	sqes = (io_uring_sqe*)mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+	if (sqes == MAP_FAILED)
+	{
+		return -1;
+	}
+
+	sq_tail = (uint32_t*)((uint8_t*)sq_ring + params.sq_off.tail);
+	sq_mask = (uint32_t*)((uint8_t*)sq_ring + params.sq_off.ring_mask);
+	sq_array = (uint32_t*)((uint8_t*)sq_ring + params.sq_off.array);
+	cq_head = (uint32_t*)((uint8_t*)cq_ring + params.cq_off.head);
+	cq_tail = (uint32_t*)((uint8_t*)cq_ring + params.cq_off.tail);
+	cq_mask = (uint32_t*)((uint8_t*)cq_ring + params.cq_off.ring_mask);
+	cqes = (io_uring_cqe*)((uint8_t*)cq_ring + params.cq_off.cqes);
+	return 0;
+}
+
+void uring::queue_read(int file, void* data, uint32_t length, uint64_t offset, uint64_t user_data)
+{
+	// Only this thread writes the tail, the kernel reads it after enter().
+	const uint32_t tail = *sq_tail + queued;
+	const uint32_t index = tail & *sq_mask;
+	io_uring_sqe&  sqe = sqes[index];
+	memset(&sqe, 0, sizeof(sqe));
+	sqe.opcode = IORING_OP_READ;
+	sqe.fd = file;
+	sqe.off = offset;
+	sqe.addr = (uint64_t)data;
+	sqe.len = length;
+	sqe.user_data = user_data;
+	sq_array[index] = index;
+	queued++;
+}
+
+int uring::enter(uint32_t min_complete)
+{
+	__atomic_store_n(sq_tail, *sq_tail + queued, __ATOMIC_RELEASE);
+	uint32_t to_submit = queued;
+	queued = 0;
+	for (;;)
+	{
+		const long submitted = syscall(__NR_io_uring_enter, fd, to_submit, min_complete, IORING_ENTER_GETEVENTS, nullptr, 0);
+		if (submitted >= 0)
+		{
+			return 0;
+		}
+		if (errno != EINTR)
+		{
+			ERR("io_uring_enter failed: %s\n", strerror(errno));
+			return -1;
+		}
+		// Entries are consumed before the wait is interrupted.
+		to_submit = 0;
+	}
+}
+
+bool uring::reap(io_uring_cqe& cqe)
+{
+	const uint32_t head = *cq_head;
+	if (head == __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE))
+	{
+		return false;
+	}
+	cqe = cqes[head & *cq_mask];
+	__atomic_store_n(cq_head, head + 1, __ATOMIC_RELEASE);
+	return true;
+}
+
+/// Range of the file read by one request, shortened by short reads.
+struct load_request
+{
+	uint64_t offset;
+
+	uint64_t end;
+};
+
+static uint32_t get_read_length(const load_request& request, bool direct)
+{
+	const uint64_t length = request.end - request.offset;
+	return (uint32_t)(direct ? round_up(length, FILE_LOAD_ALIGNMENT) : length);
+}
+
+static int load_by_uring(uring& ring, const int fd, const char* const path, const uint64_t file_offset, uint8_t* const data, const size_t size, const bool direct)
+{
+	load_request requests[FILE_LOAD_QUEUE_DEPTH];
+	uint32_t     free_slots[FILE_LOAD_QUEUE_DEPTH];
+	uint32_t     free_count = 0;
+	for (uint32_t slot = 0; slot < FILE_LOAD_QUEUE_DEPTH; ++slot)
+	{
+		free_slots[free_count++] = FILE_LOAD_QUEUE_DEPTH - 1 - slot;
+	}
+
+	uint64_t next_offset = 0;
+	uint32_t in_flight = 0;
+	bool     failed = false;
+	do
+	{
+		while (!failed && free_count && next_offset < size)
+		{
+			const uint32_t slot = free_slots[--free_count];
+			requests[slot].offset = next_offset;
+			requests[slot].end = std::min<uint64_t>(next_offset + FILE_LOAD_CHUNK_SIZE, size);
+			next_offset = requests[slot].end;
+			ring.queue_read(fd, data + requests[slot].offset, get_read_length(requests[slot], direct), file_offset + requests[slot].offset, slot);
+			in_flight++;
+		}
+
+		// The reads in flight have to finish even after a failure, they write to the buffer.
+		if (ring.enter(1) < 0)
+		{
+			return -1;
+		}
+		io_uring_cqe cqe;
+		while (ring.reap(cqe))
+		{
+			load_request& request = requests[cqe.user_data];
+			if (cqe.res <= 0)
+			{
+				if (!failed)
+				{
+					ERR("read of %s at offset %lu failed: %s\n",
+							path, (unsigned long)request.offset, cqe.res < 0 ? strerror(-cqe.res) : "unexpected end of file");
+				}
+				failed = true;
+			}
+			else
+			{
+				request.offset += cqe.res;
+				if (!failed && request.offset < request.end)
+				{
+					ring.queue_read(fd, data + request.offset, get_read_length(request, direct), file_offset + request.offset, cqe.user_data);
+					continue;
+				}
+			}
+			free_slots[free_count++] = (uint32_t)cqe.user_data;
+			in_flight--;
+		}
+	} while (in_flight || (!failed && next_offset < size));
+
+	return failed ? -1 : 0;
+}
+
+/// Work shared by the threads of load_by_threads().
+struct load_threads_data
+{
+	int                   fd;
+
+	const char*           path;
+
+	uint64_t              file_offset;
+
+	uint8_t*              data;
+
+	size_t                size;
+
+	bool                  direct;
+
+	std::atomic<uint64_t> next_chunk{0};
+
+	std::atomic<bool>     failed{false};
+};
+
+static void* load_thread_func(void* arg)
+{
+	load_threads_data& load = *(load_threads_data*)arg;
+	for (;;)
+	{
+		const uint64_t chunk = load.next_chunk.fetch_add(1);
+		load_request   request;
+		request.offset = chunk * FILE_LOAD_CHUNK_SIZE;
+		if (request.offset >= load.size || load.failed)
+		{
+			return nullptr;
+		}
+		request.end = std::min<uint64_t>(request.offset + FILE_LOAD_CHUNK_SIZE, load.size);
+		while (request.offset < request.end)
+		{
+			const ssize_t result = pread(load.fd, load.data + request.offset, get_read_length(request, load.direct), load.file_offset + request.offset);
+			if (result < 0 && errno == EINTR)
+			{
+				continue;
+			}
+			if (result <= 0)
+			{
+				ERR("read of %s at offset %lu failed\n", load.path, (unsigned long)request.offset);
+				load.failed = true;
+				return nullptr;
+			}
+			request.offset += result;
+		}
+	}
+}
+
+static int load_by_threads(const int fd, const char* const path, const uint64_t file_offset, uint8_t* const data, const size_t size, const bool direct)
+{
+	load_threads_data load;
+	load.fd = fd;
+	load.path = path;
+	load.file_offset = file_offset;
+	load.data = data;
+	load.size = size;
+	load.direct = direct;
+
+	// The calling thread is one of the readers.
+	const uint64_t chunk_count = (size + FILE_LOAD_CHUNK_SIZE - 1) / FILE_LOAD_CHUNK_SIZE;
+	const uint32_t thread_count = (uint32_t)std::min<uint64_t>(FILE_LOAD_QUEUE_DEPTH, chunk_count);
+	pthread_t      threads[FILE_LOAD_QUEUE_DEPTH];
+	uint32_t       started = 0;
+	for (uint32_t i = 1; i < thread_count; ++i)
+	{
+		if (pthread_create(&threads[started], nullptr, load_thread_func, &load) != 0)
+		{
+			break;
+		}
+		started++;
+	}
+	load_thread_func(&load);
+	for (uint32_t i = 0; i < started; ++i)
+	{
+		pthread_join(threads[i], nullptr);
+	}
+
+	return load.failed ? -1 : 0;
+}
+
+int load_file(const char* path, uint64_t offset, void* data, size_t size, bool direct)
+{
+	if (size == 0)
+	{
+		return 0;
+	}
+
+	int fd = open(path, O_RDONLY | (direct ? O_DIRECT : 0));
+	if (fd < 0 && direct && errno == EINVAL)
+	{
+		INFO("%s does not support O_DIRECT, reading it through the page cache\n", path);
+		direct = false;
+		fd = open(path, O_RDONLY);
+	}
+	if (fd < 0)
+	{
+		ERR("open(%s) failed\n", path);
+		return -1;
+	}
+	auto close_fd = scope_exit([&]() { close(fd); });
+
+	int   result;
+	uring ring;
+	if (ring.open(FILE_LOAD_QUEUE_DEPTH) == 0)
+	{
+		result = load_by_uring(ring, fd, path, offset, (uint8_t*)data, size, direct);
+	}
+	else
+	{
+		INFO("io_uring is not available, reading %s by %u threads\n", path, FILE_LOAD_QUEUE_DEPTH);
+		result = load_by_threads(fd, path, offset, (uint8_t*)data, size, direct);
+	}
+
+	// Reads with O_DIRECT may continue past the end of the requested range.
+	memset((uint8_t*)data + size, 0, round_up(size, FILE_LOAD_ALIGNMENT) - size);
+	return result;
+}
@@ -0,0 +1,37 @@
+#ifndef _FILE_LOADER_H_
+#define _FILE_LOADER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// Size of the chunks the file is read in.
+constexpr size_t   FILE_LOAD_CHUNK_SIZE  = 1024 * 1024;
+/// Count of chunks read at once.
+constexpr uint32_t FILE_LOAD_QUEUE_DEPTH = 32;
+/// Alignment of offsets and lengths of reads with O_DIRECT.
+constexpr size_t   FILE_LOAD_ALIGNMENT   = 4096;
+
+/** Reads @p size bytes of a file from @p offset to memory in parallel chunks.
+ *
+ * Up to FILE_LOAD_QUEUE_DEPTH chunks are in flight in an io_uring. Where
+ * io_uring is not available (old kernel, blocked by seccomp), the chunks are
+ * read by as many threads calling pread().
+ *
+ * The reads touch the pages of @p data first, so the memory policy of the
+ * buffer decides where the pages are placed.
+ *
+ * @param path   Path to the file, the file has to hold @p size bytes after @p offset.
+ * @param offset Offset of the first byte in the file, aligned to FILE_LOAD_ALIGNMENT
+ *               for O_DIRECT.
+ * @param data   Destination, aligned to FILE_LOAD_ALIGNMENT and writable up to
+ *               @p size rounded up to FILE_LOAD_ALIGNMENT. The bytes after
+ *               @p size are zeroed.
+ * @param size   Count of bytes to read.
+ * @param direct Whether to bypass the page cache with O_DIRECT, the page cache
+ *               is used when the file system does not support it.
+ *
+ * @return 0 on success, -1 on failure.
+ */
+int load_file(const char* path, uint64_t offset, void* data, size_t size, bool direct);
+
+#endif /* end of include guard: _FILE_LOADER_H_ */
@@ -0,0 +1,914 @@
+#include "ya_getopt.h"
+#include "bench_common.h"
+#include "cache_topology.h"
+#include "common.h"
+#include "cpu_features.h"
+#include "file_header.h"
+#include "generator.h"
+#include "kernels.h"
+#include "input_buffer.h"
+#include "latency_histogram.h"
+#include "memory.h"
+#include "named_value.h"
+#include "scope_guard.h"
+
+#include <pthread.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+
+/** Benchmark harness sweeping kernels, thread counts and table sizes in one process.
+ *
+ * The input files are loaded once at the largest swept size, smaller tables use the
+ * beginning of the buffer. Generated indices are generated again for each table size
+ * and reduction, so they look up the generated elements of each table. Every
+ * configuration runs the warmup repetitions first, then the measured ones. A
+ * repetition releases all threads at once after they are created and its sample is
+ * the sum of the throughputs of the threads.
+ *
+ * Table sizes "auto" are picked around the boundaries of the cache hierarchy and the
+ * STLB, and each result tells the level the table fits in.
+ */
+
+constexpr uint32_t          SWEEP_VALUES_MAX            = 64;
+constexpr uint32_t          KERNELS_MAX                 = 32;
+constexpr uint32_t          REDUCTIONS_MAX              = 3;
+constexpr uint32_t          REPETITIONS_MAX             = 1000;
+constexpr uint32_t          CYCLE_COUNT_DEFAULT         = 100;
+constexpr uint32_t          WARMUP_COUNT_DEFAULT        = 1;
+constexpr uint32_t          REPETITION_COUNT_DEFAULT    = 10;
+constexpr const char* const THREAD_COUNTS_DEFAULT       = "1";
+constexpr const char* const TABLE_SIZES_DEFAULT         = "2048-67108864";
+// Table sizes "auto" are these eighths of each boundary of the hierarchy.
+constexpr uint32_t          CACHE_SWEEP_EIGHTHS[]       = {4, 6, 7, 8, 9, 10, 12, 16};
+
+struct bench_config
+{
+	char               location_of_files[2048] = {};
+
+	uint32_t           indices_buffer_size = INDICES_BUFFER_SIZE_DEFAULT;
+
+	uint64_t           table_sizes[SWEEP_VALUES_MAX] = {};
+
+	uint32_t           table_size_count = 0;
+
+	uint32_t           thread_counts[SWEEP_VALUES_MAX] = {};
+
+	uint32_t           thread_count_count = 0;
+
+	const kernel_desc* kernels[KERNELS_MAX] = {};
+
+	uint32_t           kernel_count = 0;
+
+	/// Reductions of the indices to the table, none selects mask for power of two tables and multiply for the others.
+	table_reduction    reductions[REDUCTIONS_MAX] = {};
+
+	uint32_t           reduction_count = 0;
+
+	/// Passes over the indices in one repetition.
+	uint32_t           cycle_count = CYCLE_COUNT_DEFAULT;
+
+	uint32_t           warmup_count = WARMUP_COUNT_DEFAULT;
+
+	uint32_t           repetition_count = REPETITION_COUNT_DEFAULT;
+
+	table_format       format = table_format::u16;
+
+	/// Generate the table and the indices in memory instead of reading the files.
+	bool               generate = false;
+
+	generator_config   generator;
+
+	/// Boundaries of the cache hierarchy the results are annotated with.
+	cache_boundary     boundaries[CACHE_BOUNDARIES_MAX] = {};
+
+	uint32_t           boundary_count = 0;
+};
+
+/// One configuration of the sweep.
+struct bench_run
+{
+	const bench_config* conf;
+
+	const kernel_desc*  kernel;
+
+	const uint32_t*     indices;
+
+	uint32_t            count_of_indices;
+
+	const void*         table;
+
+	table_indexing      indexing;
+
+	bool                wide_indices;
+
+	uint32_t            partition_bits;
+
+	start_gate          start;
+
+	/// Threads wait for each other after they copy the indices, so the measurements run concurrently.
+	pthread_barrier_t   measure_barrier;
+};
+
+struct bench_thread
+{
+	bench_run* run = nullptr;
+
+	uint32_t   id = 0;
+
+	/// Private copy of the indices, restored before each repetition.
+	uint32_t*  indices = nullptr;
+
+	uint32_t*  scratch = nullptr;
+
+	/// Lookups timed by latency kernels, only their throughput is reported.
+	latency_histogram histogram;
+
+	double     clock_sum = 0.0;
+
+	uint16_t   value = 0;
+};
+
+/// Statistics of the throughputs of the repetitions in MT/s.
+struct bench_stats
+{
+	double median;
+
+	double p5;
+
+	double p95;
+
+	double mean;
+
+	double stddev;
+};
+
+static void print_usage(const char *const progname)
+{
+	INFO("%s -l <location_of_input_files>|-R <distribution>[:<params>] [-Y <seed>] [-i <indices_buffer_size>] [-t <table_sizes>] [-M <table_reductions>] [-d <thread_counts>] [-k <kernels>] [-c <cycle_count>] [-w <warmup_count>] [-r <repetition_count>] [-e <table_format>] [-h]\n",
+			progname
+			);
+	INFO("indices buffer size is rounded up to a power of two, at most %u bytes\n", INDICES_BUFFER_SIZE_MAX);
+	INFO("table sizes and thread counts are comma separated lists of values or ranges a-b,\n");
+	INFO("table size ranges double, thread count ranges step by one (defaults: -t %s -d %s)\n",
+			TABLE_SIZES_DEFAULT, THREAD_COUNTS_DEFAULT);
+	INFO("table sizes which are not a power of two are rounded up to %" PRIu64 " bytes\n", TABLE_SIZE_ALIGNMENT);
+	INFO("table sizes auto are 1/2 to 2 times the sizes of the caches, L3 slices and STLB reach of this CPU,\n");
+	INFO("each result tells the cache level and whether the STLB holds the table\n");
+	INFO("table reductions is a comma separated list, mask for power of two sizes and multiply for the others by default:");
+	print_value_names(stdout, TABLE_REDUCTIONS);
+	fprintf(stdout, "\n");
+	INFO("kernels is a comma separated list, all kernels selectable by auto by default, kernels:");
+	uint32_t                 kernel_count = 0;
+	const kernel_desc* const kernels = get_kernels(kernel_count);
+	for (uint32_t i = 0; i < kernel_count; ++i)
+	{
+		fprintf(stdout, " %s", kernels[i].name);
+	}
+	fprintf(stdout, "\n");
+	INFO("table formats:");
+	print_value_names(stdout, TABLE_FORMATS);
+	fprintf(stdout, "\n");
+	INFO("generated distributions (zipf:<skew>, strided:<stride>, clustered:<size>:<length>):");
+	print_index_distributions(stdout);
+	fprintf(stdout, "\n");
+}
+
+/** Parses a comma separated list of values and ranges.
+ *
+ * @param geometric   Whether ranges double the value instead of incrementing it.
+ * @param auto_values Values of the item auto, nullptr if the list cannot have it.
+ * @param auto_count  Count of @p auto_values.
+ *
+ * @return 0 on success, -1 on invalid list or too many values.
+ */
+template<typename T>
+static int parse_sweep(const char* str, const bool geometric, const T* auto_values, const uint32_t auto_count, T* values, uint32_t& count)
+{
+	constexpr uint64_t value_max = (T)~(T)0;
+	count = 0;
+	while (*str)
+	{
+		if (auto_values && !strncmp(str, "auto", 4) && (str[4] == ',' || !str[4]))
+		{
+			if (!auto_count || count + auto_count > SWEEP_VALUES_MAX)
+			{
+				return -1;
+			}
+			std::copy(auto_values, auto_values + auto_count, values + count);
+			count += auto_count;
+			str += str[4] ? 5 : 4;
+			continue;
+		}
+
+		char*          end = nullptr;
+		const uint64_t first = strtoull(str, &end, 10);
+		uint64_t       last = first;
+		if (end == str || !first || first > value_max)
+		{
+			return -1;
+		}
+		if (*end == '-')
+		{
+			str = end + 1;
+			last = strtoull(str, &end, 10);
+			if (end == str || last < first || last > value_max)
+			{
+				return -1;
+			}
+		}
+		for (uint64_t value = first; value <= last; value = geometric ? value * 2 : value + 1)
+		{
+			if (count == SWEEP_VALUES_MAX)
+			{
+				return -1;
+			}
+			values[count++] = (T)value;
+			if (geometric && value > last / 2)
+			{
+				break;
+			}
+		}
+		if (*end == ',')
+		{
+			end++;
+		}
+		else if (*end)
+		{
+			return -1;
+		}
+		str = end;
+	}
+	return count ? 0 : -1;
+}
+
+static int parse_kernels(const char* str, bench_config& conf)
+{
+	char names[1024];
+	if (strlen(str) >= sizeof(names))
+	{
+		return -1;
+	}
+	strcpy(names, str);
+
+	conf.kernel_count = 0;
+	char* save = nullptr;
+	for (char* name = strtok_r(names, ",", &save); name; name = strtok_r(nullptr, ",", &save))
+	{
+		const kernel_desc* const kernel = find_kernel(name);
+		if (!kernel || conf.kernel_count == KERNELS_MAX)
+		{
+			ERR("unknown kernel %s\n", name);
+			return -1;
+		}
+		conf.kernels[conf.kernel_count++] = kernel;
+	}
+	return conf.kernel_count ? 0 : -1;
+}
+
+static int parse_reductions(const char* str, bench_config& conf)
+{
+	char names[256];
+	if (strlen(str) >= sizeof(names))
+	{
+		return -1;
+	}
+	strcpy(names, str);
+
+	conf.reduction_count = 0;
+	char* save = nullptr;
+	for (char* name = strtok_r(names, ",", &save); name; name = strtok_r(nullptr, ",", &save))
+	{
+		table_reduction reduction;
+		if (parse_named_value(TABLE_REDUCTIONS, name, reduction) < 0 || conf.reduction_count == REDUCTIONS_MAX)
+		{
+			ERR("unknown table reduction %s\n", name);
+			return -1;
+		}
+		conf.reductions[conf.reduction_count++] = reduction;
+	}
+	return conf.reduction_count ? 0 : -1;
+}
+
+static int parse_args(int argc, char *argv[], bench_config& conf)
+{
+	struct option longopts[] =
+	{
+		{
+			/* name */ "location-of-files",
+			/* has_arg */ya_required_argument,
+			/* flag */nullptr,
+			/* val */'l'
+		},
+		{
+			/* name */ "indices-buffer-size",
+			/* has_arg */ya_required_argument,
+			/* flag */nullptr,
+			/* val */'i'
+		},
+		{
+			/* name */ "table-sizes",
+			/* has_arg */ya_required_argument,
+			/* flag */nullptr,
+			/* val */'t'
+		},
+		{
+			/* name */ "thread-counts",
+			/* has_arg */ya_required_argument,
+			/* flag */nullptr,
+			/* val */'d'
+		},
+		{
+			/* name */ "kernels",
+			/* has_arg */ya_required_argument,
+			/* flag */nullptr,
+			/* val */'k'
+		},
+		{
+			/* name */ "cycle-count",
+			/* has_arg */ya_required_argument,
+			/* flag */nullptr,
+			/* val */'c'
+		},
+		{
+			/* name */ "warmup-count",
+			/* has_arg */ya_required_argument,
+			/* flag */nullptr,
+			/* val */'w'
+		},
+		{
+			/* name */ "repetition-count",
+			/* has_arg */ya_required_argument,
+			/* flag */nullptr,
+			/* val */'r'
+		},
+		{
+			/* name */ "table-reductions",
+			/* has_arg */ya_required_argument,
+			/* flag */nullptr,
+			/* val */'M'
+		},
+		{
+			/* name */ "table-format",
+			/* has_arg */ya_required_argument,
+			/* flag */nullptr,
+			/* val */'e'
+		},
+		{
+			/* name */ "generate",
+			/* has_arg */ya_required_argument,
+			/* flag */nullptr,
+			/* val */'R'
+		},
+		{
+			/* name */ "seed",
+			/* has_arg */ya_required_argument,
+			/* flag */nullptr,
+			/* val */'Y'
+		},
+		{
+			/* name */ "help",
+			/* has_arg */ya_no_argument,
+			/* flag */nullptr,
+			/* val */'h'
+		},
+		{
+			/* name */ nullptr,
+			/* has_arg */ya_no_argument,
+			/* flag */nullptr,
+			/* val */0
+		}
+	};
+
+	ya_context ya_getopt_context;
+	ya_context_initx(&ya_getopt_context);
+
+	const char* table_sizes = TABLE_SIZES_DEFAULT;
+	const char* thread_counts = THREAD_COUNTS_DEFAULT;
+	int         longindex = 0;
+	int         optopt = 0;
+	while ((optopt = ya_getopt_long(&ya_getopt_context, argc, argv, "l:i:t:M:d:k:c:w:r:e:R:Y:h", longopts, &longindex)) != -1)
+	{
+		switch (optopt)
+		{
+			case 'l':
+				if (strlen(ya_getopt_context.ya_optarg) >= sizeof(conf.location_of_files))
+				{
+					ERR("location of files too long\n");
+					return -1;
+				}
+				strcpy(conf.location_of_files, ya_getopt_context.ya_optarg);
+				break;
+
+			case 'i':
+				conf.indices_buffer_size = (uint32_t)get_buffer_size(ya_getopt_context.ya_optarg, INDICES_BUFFER_SIZE_MAX);
+				if (!conf.indices_buffer_size)
+				{
+					ERR("invalid indices buffer size %s\n", ya_getopt_context.ya_optarg);
+					return -1;
+				}
+				break;
+
+			case 't':
+				table_sizes = ya_getopt_context.ya_optarg;
+				break;
+
+			case 'M':
+				if (parse_reductions(ya_getopt_context.ya_optarg, conf) < 0)
+				{
+					ERR("invalid table reductions %s\n", ya_getopt_context.ya_optarg);
+					return -1;
+				}
+				break;
+
+			case 'd':
+				thread_counts = ya_getopt_context.ya_optarg;
+				break;
+
+			case 'k':
+				if (parse_kernels(ya_getopt_context.ya_optarg, conf) < 0)
+				{
+					ERR("invalid kernels %s\n", ya_getopt_context.ya_optarg);
+					return -1;
+				}
+				break;
+
+			case 'c':
+				conf.cycle_count = (uint32_t)strtoul(ya_getopt_context.ya_optarg, nullptr, 10);
+				break;
+
+			case 'w':
+				conf.warmup_count = (uint32_t)strtoul(ya_getopt_context.ya_optarg, nullptr, 10);
+				break;
+
+			case 'r':
+				conf.repetition_count = (uint32_t)strtoul(ya_getopt_context.ya_optarg, nullptr, 10);
+				break;
+
+			case 'e':
+				if (parse_named_value(TABLE_FORMATS, ya_getopt_context.ya_optarg, conf.format) < 0)
+				{
+					ERR("unknown table format %s\n", ya_getopt_context.ya_optarg);
+					return -1;
+				}
+				break;
+
+			case 'R':
+				if (parse_generator_spec(ya_getopt_context.ya_optarg, conf.generator) < 0)
+				{
+					ERR("invalid distribution %s\n", ya_getopt_context.ya_optarg);
+					return -1;
+				}
+				conf.generate = true;
+				break;
+
+			case 'Y':
+				conf.generator.seed = strtoull(ya_getopt_context.ya_optarg, nullptr, 10);
+				break;
+
+			case 'h':
+				print_usage(argv[0]);
+				return -1;
+
+			default:
+				return -1;
+		}
+	}
+
+	if (!conf.location_of_files[0] && !conf.generate)
+	{
+		ERR("location of files not given\n");
+		return -1;
+	}
+
+	cache_topology topology;
+	if (detect_cache_topology(topology) == 0)
+	{
+		conf.boundary_count = get_cache_boundaries(topology, conf.boundaries, CACHE_BOUNDARIES_MAX);
+	}
+
+	// Table sizes are in elements of TABLE_ELEMENT_SIZE, the boundaries are in bytes of the table format.
+	uint64_t auto_sizes[CACHE_BOUNDARIES_MAX * sizeof(CACHE_SWEEP_EIGHTHS) / sizeof(CACHE_SWEEP_EIGHTHS[0])];
+	uint32_t auto_count = 0;
+	for (uint32_t i = 0; i < conf.boundary_count; ++i)
+	{
+		for (const uint32_t eighths : CACHE_SWEEP_EIGHTHS)
+		{
+			const uint64_t bytes = conf.boundaries[i].size * eighths / 8;
+			const uint64_t size = bytes * 8 / get_table_element_bits(conf.format) * TABLE_ELEMENT_SIZE;
+			auto_sizes[auto_count++] = std::max(size, TABLE_SIZE_ALIGNMENT);
+		}
+	}
+	if (parse_sweep(table_sizes, true, auto_sizes, auto_count, conf.table_sizes, conf.table_size_count) < 0)
+	{
+		ERR("invalid table sizes %s%s\n", table_sizes, conf.boundary_count ? "" : ", cache hierarchy not detected");
+		return -1;
+	}
+	const bool mask_given = std::find(conf.reductions, conf.reductions + conf.reduction_count, table_reduction::mask) !=
+			conf.reductions + conf.reduction_count;
+	for (uint32_t i = 0; i < conf.table_size_count; ++i)
+	{
+		uint64_t& size = conf.table_sizes[i];
+		size = align_table_buffer_size(size);
+		if (size < TABLE_ELEMENT_SIZE || (mask_given && (size & (size - 1))))
+		{
+			ERR("table size %" PRIu64 " is not a power of two for the mask reduction\n", size);
+			return -1;
+		}
+	}
+	if (auto_count)
+	{
+		// Points of neighbouring boundaries may coincide.
+		std::sort(conf.table_sizes, conf.table_sizes + conf.table_size_count);
+		conf.table_size_count = (uint32_t)(std::unique(conf.table_sizes, conf.table_sizes + conf.table_size_count) - conf.table_sizes);
+	}
+
+	if (parse_sweep(thread_counts, false, (const uint32_t*)nullptr, 0, conf.thread_counts, conf.thread_count_count) < 0)
+	{
+		ERR("invalid thread counts %s\n", thread_counts);
+		return -1;
+	}
+	for (uint32_t i = 0; i < conf.thread_count_count; ++i)
+	{
+		if (conf.thread_counts[i] > THREADS_MAX)
+		{
+			ERR("thread count %u exceeds %u\n", conf.thread_counts[i], THREADS_MAX);
+			return -1;
+		}
+	}
+
+	if (conf.indices_buffer_size < sizeof(uint32_t) || !conf.cycle_count ||
+		!conf.repetition_count || conf.repetition_count > REPETITIONS_MAX)
+	{
+		ERR("invalid indices buffer size, cycle count or repetition count\n");
+		return -1;
+	}
+
+	const uint32_t cpu_features = detect_cpu_features();
+	if (!conf.kernel_count)
+	{
+		uint32_t                 kernel_count = 0;
+		const kernel_desc* const kernels = get_kernels(kernel_count);
+		for (uint32_t i = 0; i < kernel_count && conf.kernel_count < KERNELS_MAX; ++i)
+		{
+			if (!kernels[i].flags && (kernels[i].required_features & cpu_features) == kernels[i].required_features)
+			{
+				conf.kernels[conf.kernel_count++] = &kernels[i];
+			}
+		}
+	}
+	for (uint32_t i = 0; i < conf.kernel_count; ++i)
+	{
+		if ((conf.kernels[i]->required_features & cpu_features) != conf.kernels[i]->required_features)
+		{
+			ERR("kernel %s not supported by this CPU\n", conf.kernels[i]->name);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static void* thread_func(bench_thread* thr)
+{
+	pin_thread(thr->id);
+
+	bench_run* const run = thr->run;
+	memcpy(thr->indices, run->indices, run->count_of_indices * sizeof(uint32_t));
+
+	const kernel_context ctx =
+	{
+		/* indices */ thr->indices,
+		/* table */ run->table,
+		/* format */ run->conf->format,
+		/* count_of_indices */ run->count_of_indices,
+		/* indexing */ run->indexing,
+		/* wide_indices */ run->wide_indices,
+		/* thread_id */ thr->id,
+		/* prefetch_distance */ PREFETCH_DISTANCE_DEFAULT,
+		/* prefetch_locality */ prefetch_hint::t0,
+		/* stream_count */ STREAM_COUNT_DEFAULT,
+		/* alphabet_size */ ALPHABET_SIZE_DEFAULT,
+		/* partition_bits */ run->partition_bits,
+		/* batch_size */ BATCH_SIZE_DEFAULT,
+		/* scratch */ thr->scratch,
+		/* latency_interval */ LATENCY_INTERVAL_DEFAULT,
+		/* histogram */ &thr->histogram
+	};
+	const kernel_func kernel = run->kernel->func;
+	const uint32_t    cycles = run->conf->cycle_count;
+	uint16_t          value = 0;
+	struct timespec   start;
+	struct timespec   end;
+
+	if (!wait_for_start(run->start))
+	{
+		return nullptr;
+	}
+	pthread_barrier_wait(&run->measure_barrier);
+
+	clock_gettime(CLOCK_MONOTONIC_RAW, &start);
+	for (uint32_t cycle = 0; cycle < cycles; ++cycle)
+	{
+		value ^= kernel(ctx);
+	}
+	clock_gettime(CLOCK_MONOTONIC_RAW, &end);
+
+	thr->clock_sum = get_clockdiff_ms(&start, &end);
+	thr->value = value;
+
+	return nullptr;
+}
+
+/** Runs one repetition of the configuration.
+ *
+ * @param throughput Output for the sum of the throughputs of the threads in MT/s.
+ * @param value      Output for the value computed by the threads.
+ *
+ * @return 0 on success, -1 if not all threads could be created.
+ */
+static int run_repetition(
+		bench_run&    run,
+		bench_thread* threads_data,
+		const uint32_t thread_count,
+		double&       throughput,
+		uint16_t&     value)
+{
+	pthread_t threads[THREADS_MAX] = {};
+	uint32_t  created = 0;
+	close_start_gate(run.start);
+	pthread_barrier_init(&run.measure_barrier, nullptr, thread_count);
+	auto destroy_barrier = scope_exit([&]() { pthread_barrier_destroy(&run.measure_barrier); });
+	for (; created < thread_count; ++created)
+	{
+		if (pthread_create(&threads[created], nullptr, (void*(*)(void*))thread_func, (void*)&threads_data[created]) != 0)
+		{
+			break;
+		}
+	}
+
+	open_start_gate(run.start, created < thread_count);
+	if (created < thread_count)
+	{
+		for (uint32_t i = 0; i < created; ++i)
+		{
+			pthread_join(threads[i], nullptr);
+		}
+		ERR("created only %u of %u threads\n", created, thread_count);
+		return -1;
+	}
+
+	throughput = 0.0;
+	value = 0;
+	for (uint32_t i = 0; i < thread_count; ++i)
+	{
+		pthread_join(threads[i], nullptr);
+		throughput += (((double)run.conf->cycle_count * run.count_of_indices) / 1000.0) / threads_data[i].clock_sum;
+		value += threads_data[i].value;
+	}
+	return 0;
+}
+
+/// Percentile @p p of sorted @p samples, interpolated between the closest ranks.
+static double get_percentile(const double* samples, const uint32_t count, const double p)
+{
+	const double   rank = p * (count - 1);
+	const uint32_t lower = (uint32_t)rank;
+	const uint32_t upper = std::min(lower + 1, count - 1);
+	return samples[lower] + (samples[upper] - samples[lower]) * (rank - lower);
+}
+
+static bench_stats get_stats(double* samples, const uint32_t count)
+{
+	std::sort(samples, samples + count);
+
+	bench_stats stats;
+	stats.median = get_percentile(samples, count, 0.5);
+	stats.p5 = get_percentile(samples, count, 0.05);
+	stats.p95 = get_percentile(samples, count, 0.95);
+	double sum = 0.0;
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		sum += samples[i];
+	}
+	stats.mean = sum / count;
+	double square_sum = 0.0;
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		square_sum += (samples[i] - stats.mean) * (samples[i] - stats.mean);
+	}
+	stats.stddev = count > 1 ? sqrt(square_sum / (count - 1)) : 0.0;
+	return stats;
+}
+
+/** Runs the warmup and the measured repetitions of one configuration and prints its statistics.
+ *
+ * @return 0 on success, -1 on failure.
+ */
+static int run_configuration(bench_run& run, const uint64_t table_size, const uint32_t thread_count)
+{
+	const bench_config& conf = *run.conf;
+	bench_thread        threads_data[THREADS_MAX];
+	input_buffer        thread_indices[THREADS_MAX];
+	input_buffer        thread_scratch[THREADS_MAX];
+	for (uint32_t thread_id = 0; thread_id < thread_count; ++thread_id)
+	{
+		bench_thread& thr = threads_data[thread_id];
+		thr.run = &run;
+		thr.id = thread_id;
+
+		// The copies are first touched by the threads.
+		const size_t size = run.count_of_indices * sizeof(uint32_t);
+		page_mode    obtained;
+		size_t       mapped_size;
+		void* const  indices = allocate_pages(size, page_mode::normal, obtained, mapped_size);
+		if (!indices)
+		{
+			ERR("failed to allocate indices of thread %u\n", thread_id);
+			return -1;
+		}
+		thread_indices[thread_id] = input_buffer::from_mapping(indices, size, mapped_size);
+		thr.indices = thread_indices[thread_id].get<uint32_t>();
+
+		if (run.kernel->flags & KERNEL_FLAG_PARTITION)
+		{
+			const size_t scratch_size = get_partition_scratch_count(BATCH_SIZE_DEFAULT, run.partition_bits) * sizeof(uint32_t);
+			void* const  scratch = allocate_pages(scratch_size, page_mode::normal, obtained, mapped_size);
+			if (!scratch)
+			{
+				ERR("failed to allocate scratch of thread %u\n", thread_id);
+				return -1;
+			}
+			thread_scratch[thread_id] = input_buffer::from_mapping(scratch, scratch_size, mapped_size);
+			thr.scratch = thread_scratch[thread_id].get<uint32_t>();
+		}
+	}
+
+	double   samples[REPETITIONS_MAX];
+	uint16_t value = 0;
+	for (uint32_t repetition = 0; repetition < conf.warmup_count + conf.repetition_count; ++repetition)
+	{
+		double throughput = 0.0;
+		if (run_repetition(run, threads_data, thread_count, throughput, value) < 0)
+		{
+			return -1;
+		}
+		if (repetition >= conf.warmup_count)
+		{
+			samples[repetition - conf.warmup_count] = throughput;
+		}
+	}
+
+	// Level of the hierarchy holding the table, the STLB is unknown if cpuid does not report it.
+	const size_t                bytes = get_table_size(conf.format, table_size / TABLE_ELEMENT_SIZE);
+	const cache_boundary* const level = find_cache_boundary(conf.boundaries, conf.boundary_count, bytes, boundary_kind::cache);
+	const bool                  stlb_known = find_cache_boundary(conf.boundaries, conf.boundary_count, 0, boundary_kind::tlb);
+	const bool                  stlb_fits = find_cache_boundary(conf.boundaries, conf.boundary_count, bytes, boundary_kind::tlb);
+
+	const bench_stats stats = get_stats(samples, conf.repetition_count);
+	INFO("%-12s %7u %11" PRIu64 " %-9s %-8s %-4s %12.4f %12.4f %12.4f %12.4f %12.4f %6u\n",
+			run.kernel->name, thread_count, table_size, get_value_name(TABLE_REDUCTIONS, run.indexing.reduction),
+			level ? level->name : "memory", stlb_known ? (stlb_fits ? "yes" : "no") : "?",
+			stats.median, stats.p5, stats.p95, stats.mean, stats.stddev, value);
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	bench_config conf;
+	if (parse_args(argc, argv, conf) < 0)
+	{
+		ERR("failed to parse command line arguments\n");
+		return -1;
+	}
+
+	const uint64_t table_size_max = *std::max_element(conf.table_sizes, conf.table_sizes + conf.table_size_count);
+	input_buffer   indices_buffer;
+	input_buffer   table_buffer;
+	table_indexing generated_indexing = {};
+	if (conf.generate)
+	{
+		if (init_table_indexing(get_default_reduction(table_size_max / TABLE_ELEMENT_SIZE), table_size_max / TABLE_ELEMENT_SIZE, generated_indexing) < 0 ||
+			generate_input_buffers(
+				conf.generator,
+				conf.indices_buffer_size,
+				generated_indexing,
+				conf.format,
+				page_mode::normal,
+				TABLE_BUFFER_PADDING,
+				indices_buffer,
+				table_buffer) < 0)
+		{
+			ERR("failed to generate buffers\n");
+			return -1;
+		}
+		char spec[64];
+		format_generator_spec(conf.generator, spec, sizeof(spec));
+		INFO("generated distribution : %s, seed %" PRIu64 "\n", spec, conf.generator.seed);
+	}
+	else
+	{
+		char         path[FILE_PATH_MAX];
+		file_payload payload;
+		if (get_data_file_path(path, sizeof(path), conf.location_of_files, FILE_WITH_INDICES) < 0)
+		{
+			return -1;
+		}
+		if (read_input_buffer(
+				conf.location_of_files,
+				FILE_WITH_INDICES,
+				conf.indices_buffer_size,
+				0,
+				load_mode::read,
+				page_mode::normal,
+				false,
+				indices_buffer,
+				payload) < 0 ||
+			check_file_header(payload, path, file_content::indices, sizeof(uint32_t) * 8) < 0 ||
+			verify_payload_crc(payload, path, indices_buffer.get<void>(), indices_buffer.get_size()) < 0)
+		{
+			ERR("failed to read buffer with indices\n");
+			return -1;
+		}
+
+		if (get_data_file_path(path, sizeof(path), conf.location_of_files, get_table_file_name(conf.format)) < 0)
+		{
+			return -1;
+		}
+		if (read_input_buffer(
+				conf.location_of_files,
+				get_table_file_name(conf.format),
+				get_table_size(conf.format, table_size_max / TABLE_ELEMENT_SIZE),
+				TABLE_BUFFER_PADDING,
+				load_mode::read,
+				page_mode::normal,
+				false,
+				table_buffer,
+				payload) < 0 ||
+			check_file_header(payload, path, file_content::table, get_table_element_bits(conf.format)) < 0 ||
+			verify_payload_crc(payload, path, table_buffer.get<void>(), table_buffer.get_size()) < 0)
+		{
+			ERR("failed to read buffer with table\n");
+			return -1;
+		}
+	}
+
+	INFO("indices buffer size: %u\n", conf.indices_buffer_size);
+	INFO("table format : %s\n", get_value_name(TABLE_FORMATS, conf.format));
+	INFO("cycles: %u, warmup repetitions: %u, repetitions: %u\n", conf.cycle_count, conf.warmup_count, conf.repetition_count);
+	char boundaries[512];
+	format_cache_boundaries(conf.boundaries, conf.boundary_count, boundaries, sizeof(boundaries));
+	INFO("cache hierarchy : %s\n", conf.boundary_count ? boundaries : "not detected");
+	INFO("%-12s %7s %11s %-9s %-8s %-4s %12s %12s %12s %12s %12s %6s\n",
+			"kernel", "threads", "table_size", "reduction", "level", "stlb",
+			"median MT/s", "p5 MT/s", "p95 MT/s", "mean MT/s", "stddev MT/s", "value");
+
+	const long     online_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	const uint32_t cpu_count = online_cpus > 0 ? (uint32_t)online_cpus : 1;
+	for (uint32_t k = 0; k < conf.kernel_count; ++k)
+	{
+		for (uint32_t d = 0; d < conf.thread_count_count; ++d)
+		{
+			for (uint32_t t = 0; t < conf.table_size_count; ++t)
+			{
+				const uint64_t table_size = conf.table_sizes[t];
+				const uint64_t count_of_table_elements = table_size / TABLE_ELEMENT_SIZE;
+				const uint32_t reduction_count = conf.reduction_count ? conf.reduction_count : 1;
+				for (uint32_t m = 0; m < reduction_count; ++m)
+				{
+					bench_run run;
+					run.conf = &conf;
+					run.kernel = conf.kernels[k];
+					run.indices = indices_buffer.get<const uint32_t>();
+					run.count_of_indices = conf.indices_buffer_size / sizeof(uint32_t);
+					run.table = table_buffer.get<const void>();
+					if (init_table_indexing(
+							conf.reduction_count ? conf.reductions[m] : get_default_reduction(count_of_table_elements),
+							count_of_table_elements,
+							run.indexing) < 0)
+					{
+						return -1;
+					}
+					run.wide_indices = needs_wide_indices(conf.format, count_of_table_elements);
+					run.partition_bits = get_partition_bits(get_table_size(conf.format, count_of_table_elements));
+					if (conf.generate &&
+						(run.indexing.count != generated_indexing.count || run.indexing.reduction != generated_indexing.reduction))
+					{
+						generate_indices(indices_buffer.get<uint32_t>(), run.count_of_indices, run.indexing, conf.generator, cpu_count);
+						generated_indexing = run.indexing;
+					}
+					if (run_configuration(run, table_size, conf.thread_counts[d]) < 0)
+					{
+						return -1;
+					}
+				}
+			}
+		}
+	}
+
+	return 0;
+}
@@ -1,74 +1,261 @@
 #include "ya_getopt.h"
 #include "scope_guard.h"
+#include "bench_common.h"
+#include "cache_topology.h"
+#include "common.h"
+#include "cpu_features.h"
+#include "kernels.h"
+#include "input_buffer.h"
+#include "named_value.h"
+#include "numa_placement.h"
+#include "populate.h"
+#include "perf_counters.h"
+#include "latency_histogram.h"
+#include "index_stream.h"
+#include "generator.h"
+#include "file_header.h"
 
-#include <sys/stat.h>
-#include <fcntl.h>
+#include <sys/resource.h>
+#include <errno.h>
 #include <unistd.h>
 #include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 #include <algorithm>
+#include <atomic>
+#include <new>
 #include <inttypes.h>
 #include <stdio.h>
-#include <immintrin.h>
-#include <emmintrin.h>
+#include <x86intrin.h>
 
 
-#define INFO(fmt, ...) fprintf(stdout, "I " fmt, ##__VA_ARGS__)
-#define ERR(fmt, ...) fprintf(stderr, "E " fmt, ##__VA_ARGS__)
+constexpr uint64_t          TABLE_BUFFER_SIZE_MAX       = (64ull * 1024 * 1024 * 1024);
+constexpr uint64_t          TABLE_BUFFER_SIZE_DEFAULT   = (1024 * 1024 * 1024);
+// Prefetch distance selected by measuring each of PREFETCH_DISTANCES_TUNED.
+constexpr uint32_t          PREFETCH_DISTANCE_AUTO      = UINT32_MAX;
+constexpr uint32_t          PREFETCH_DISTANCES_TUNED[]  = { 0, 1, 2, 4, 8, 16, 32, 64, 128, 256 };
+constexpr uint32_t          PREFETCH_TUNE_CYCLES        = 3;
+// Stream count which runs the test with each of KERNEL_STREAM_COUNTS.
+constexpr uint32_t          STREAM_COUNT_ALL            = 0;
+// Partition bits selected by get_partition_bits().
+constexpr uint32_t          PARTITION_BITS_AUTO         = UINT32_MAX;
+constexpr double            LATENCY_PERCENTILES[]       = { 50.0, 90.0, 99.0, 99.9 };
+// Each thread processes one chunk while the next one is read.
+constexpr uint32_t          STREAM_BUFFERS_PER_THREAD   = 2;
 
+constexpr named_value<load_mode> LOAD_MODES[] =
+{
+	{ "read",         load_mode::read         },
+	{ "mmap",         load_mode::mmap         },
+	{ "mmap-hugetlb", load_mode::mmap_hugetlb },
+	{ "uring",        load_mode::uring        },
+	{ "uring-direct", load_mode::uring_direct },
+};
+
+constexpr named_value<page_mode> PAGE_MODES[] =
+{
+	{ "normal", page_mode::normal  },
+	{ "thp",    page_mode::thp     },
+	{ "2m",     page_mode::huge_2m },
+	{ "1g",     page_mode::huge_1g },
+};
+
+constexpr named_value<numa_mode> NUMA_MODES[] =
+{
+	{ "none",       numa_mode::none       },
+	{ "local",      numa_mode::local      },
+	{ "interleave", numa_mode::interleave },
+};
+
+constexpr named_value<populate_mode> POPULATE_MODES[] =
+{
+	{ "none",       populate_mode::none       },
+	{ "interleave", populate_mode::interleave },
+	{ "partition",  populate_mode::partition  },
+};
+
+/// How the threads share the buffer with indices.
+enum class indices_mode : uint32_t
+{
+	/// All threads read and write one buffer, measures the cost of cache coherence.
+	shared,
+	/// Each thread works on its own copy of the whole buffer.
+	copy,
+	/// Each thread works on its own copy of 1/thread_count of the buffer.
+	slice,
+};
+
+constexpr named_value<indices_mode> INDICES_MODES[] =
+{
+	{ "shared",  indices_mode::shared },
+	{ "private", indices_mode::copy   },
+	{ "slice",   indices_mode::slice  },
+};
+
+constexpr named_value<prefetch_hint> PREFETCH_HINTS[] =
+{
+	{ "t0",  prefetch_hint::t0  },
+	{ "nta", prefetch_hint::nta },
+};
 
-constexpr uint32_t          INDICES_BUFFER_SIZE_MAX     = (16 * 1024 * 1024);
-constexpr uint32_t          INDICES_BUFFER_SIZE_DEFAULT = (512 * 1024);
-constexpr uint32_t          TABLE_BUFFER_SIZE_MAX       = (1024 * 1024 * 1024);
-constexpr uint32_t          TABLE_BUFFER_SIZE_DEFAULT   = TABLE_BUFFER_SIZE_MAX;
-constexpr uint32_t          TABLE_ELEMENT_SIZE          = sizeof(uint16_t);
-constexpr uint32_t          TABLE_INDEX_MASK_DEFAULT    = TABLE_BUFFER_SIZE_DEFAULT / TABLE_ELEMENT_SIZE - 1;
-constexpr const char* const FILE_WITH_INDICES           = "indices.bin";
-constexpr const char* const FILE_WITH_TABLE             = "table.bin";
-constexpr uint16_t          TABLE_XOR_VAL               = 26849;
-constexpr uint16_t          TABLE_ADD_VAL               = 41387;
-constexpr uint32_t          INDEX_XOR_VAL               = (TABLE_XOR_VAL << 16) | TABLE_ADD_VAL;
+/// Format of the results printed after each run.
+enum class output_format : uint32_t
+{
+	/// INFO messages only.
+	text,
+	/// One JSON object per line and run.
+	json,
+	/// Header line and one line per thread and run.
+	csv,
+};
+
+constexpr named_value<output_format> OUTPUT_FORMATS[] =
+{
+	{ "text", output_format::text },
+	{ "json", output_format::json },
+	{ "csv",  output_format::csv  },
+};
 
 struct config
 {
 	uint32_t indices_buffer_size = INDICES_BUFFER_SIZE_DEFAULT;
 
-	uint32_t table_buffer_size = TABLE_BUFFER_SIZE_DEFAULT;
+	uint64_t table_buffer_size = TABLE_BUFFER_SIZE_DEFAULT;
 
 	char location_of_files[2048] = {};
 
-	uint32_t table_index_mask = TABLE_INDEX_MASK_DEFAULT;
+	/// Reduction of the indices to the table, mask for power of two tables and multiply for the others unless given.
+	table_reduction reduction = table_reduction::mask;
+
+	table_indexing indexing = {};
+
+	/// Whether the kernels use 64-bit table indices.
+	bool wide_indices = false;
 
 	uint32_t cycle_count = 1;
 
+	/// Passes over the indices each thread does before the measurement.
+	uint32_t warmup_cycle_count = 0;
+
+	/// Length of the measurement in seconds, 0 measures cycle_count passes instead.
+	double duration = 0.0;
+
 	uint32_t thread_count = 1;
+
+	/// Kernel forced on the command line, nullptr selects the best one supported by the CPU.
+	const kernel_desc* kernel = nullptr;
+
+	load_mode load = load_mode::read;
+
+	page_mode table_pages = page_mode::normal;
+
+	numa_mode numa = numa_mode::none;
+
+	/// Division of the table among the threads which fault its pages.
+	populate_mode populate = populate_mode::none;
+
+	indices_mode indices = indices_mode::copy;
+
+	/// Interval of sampling of the live counters in ms, 0 disables the sampling.
+	uint32_t sample_interval = 0;
+
+	/// Prefetch distance of prefetch kernels or PREFETCH_DISTANCE_AUTO.
+	uint32_t prefetch_distance = PREFETCH_DISTANCE_DEFAULT;
+
+	prefetch_hint prefetch = prefetch_hint::t0;
+
+	/// Stream count of streams kernels or STREAM_COUNT_ALL.
+	uint32_t stream_count = STREAM_COUNT_DEFAULT;
+
+	/// Count of input symbols of chain kernels.
+	uint32_t alphabet_size = ALPHABET_SIZE_DEFAULT;
+
+	/// Partition bits of partitioned kernels or PARTITION_BITS_AUTO.
+	uint32_t partition_bits = PARTITION_BITS_AUTO;
+
+	/// Count of indices partitioned at once by partitioned kernels.
+	uint32_t batch_size = BATCH_SIZE_DEFAULT;
+
+	/// Every latency_interval-th lookup is timed by latency kernels.
+	uint32_t latency_interval = LATENCY_INTERVAL_DEFAULT;
+
+	table_format format = table_format::u16;
+
+	/// File with the table, the file of the format given by -e or table.bin of any format.
+	const char* table_file_name = nullptr;
+
+	/// Convert table.bin to the other formats instead of running the test.
+	bool convert_table = false;
+
+	/// Add headers to the legacy raw files instead of running the test.
+	bool upgrade_files = false;
+
+	output_format output = output_format::text;
+
+	/// Count hardware events of each thread by perf_event_open().
+	bool perf = false;
+
+	/// Size of chunks the indices file is streamed in, 0 loads the indices to memory.
+	uint32_t stream_chunk_size = 0;
+
+	/// Generate the table and the indices in memory instead of reading the files.
+	bool generate = false;
+
+	generator_config generator;
+
+	/// Distribution of generated indices as given on the command line, "none" for the files.
+	char generator_spec[64] = "none";
+
+	/// Write the generated table.bin and indices.bin to location_of_files instead of running the test.
+	bool write_files = false;
+
+	/// Level of the cache hierarchy the table fits in, "memory" if none does.
+	char cache_level[16] = "memory";
 };
 
 struct thread_common_data
 {
-	uint32_t* const indices;
+	/// Indices used by threads of each node, all nodes share one copy unless it is replicated.
+	uint32_t* indices[NUMA_NODES_MAX] = {};
 
-	const uint16_t* const table;
+	/// Table used by threads of each node, all nodes share one copy unless it is replicated.
+	const void* table[NUMA_NODES_MAX] = {};
 
 	const uint32_t count_of_input_indices;
 
-	const uint32_t count_of_table_elements;
+	const uint64_t count_of_table_elements;
+
+	/// Threads wait at the gate after they are set up, so they start the warmup together.
+	start_gate start;
+
+	/// Threads wait for each other after the warmup, so the measurements run concurrently.
+	pthread_barrier_t measure_barrier;
+
+	/// Source of the indices if they are streamed, the indices are not in memory then.
+	index_stream* stream = nullptr;
 
 	thread_common_data(
-			uint32_t* const       indices_rhs,
-			const uint16_t* const table_rhs,
 			const uint32_t        count_of_input_indices_rhs,
-			const uint32_t        count_of_table_elements_rhs)
-		: indices(indices_rhs)
-		, table(table_rhs)
-		, count_of_input_indices(count_of_input_indices_rhs)
+			const uint64_t        count_of_table_elements_rhs)
+		: count_of_input_indices(count_of_input_indices_rhs)
 		, count_of_table_elements(count_of_table_elements_rhs)
 	{
 	}
 };
 
-struct thread_data
+// Data of each thread are aligned to pairs of cache lines, since the adjacent
+// line prefetcher fetches lines in pairs.
+constexpr size_t THREAD_DATA_ALIGNMENT = 128;
+
+/// Counters updated by the thread while it runs, sampled by main().
+struct alignas(THREAD_DATA_ALIGNMENT) thread_live_counters
+{
+	std::atomic<uint64_t> table_accesses{0};
+
+	std::atomic<bool>     finished{false};
+};
+
+struct alignas(THREAD_DATA_ALIGNMENT) thread_data
 {
 	struct config*      conf = nullptr;
 
@@ -76,47 +263,106 @@ struct thread_data
 
 	uint32_t            id = 0;
 
+	/// NUMA node of the CPU the thread runs on.
+	uint32_t            node = 0;
+
+	/// Memory for the private copy of indices, nullptr if the indices are shared.
+	uint32_t*           private_indices = nullptr;
+
+	/// Scratch memory of partitioned kernels, nullptr for the other kernels.
+	uint32_t*           scratch = nullptr;
+
+	/// First index of the buffer the thread works on.
+	uint32_t            indices_first = 0;
+
+	/// Count of indices the thread works on.
+	uint32_t            indices_count = 0;
+
 	uint16_t            value = 0;
 
 	uint64_t            table_accesses = 0;
 
 	double              clock_sum = 0.0;
+
+	/// Hardware counters of the timed loop if config::perf is set.
+	perf_counter_values perf;
+
+	/// Time stamp counter ticks of the timed loop, relates the latencies to clock_sum.
+	uint64_t            tsc_ticks = 0;
+
+	/// Latencies of the lookups timed by latency kernels.
+	latency_histogram   histogram;
+
+	thread_live_counters live;
 };
 
 static void print_usage(const char *const progname)
 {
-	INFO("%s [-l <location_of_input_files>] [-i <indices_buffer_size>] [-t <table_buffer_size>] [-c <cycle_count>] [-d <thread_count>] [-h]\n",
+	INFO("%s [-l <location_of_input_files>] [-i <indices_buffer_size>] [-t <table_buffer_size>] [-M <table_reduction>] [-c <cycle_count>] [-W <warmup_cycle_count>] [-D <duration_s>] [-d <thread_count>] [-k <kernel>] [-m <load_mode>] [-p <table_page_mode>] [-n <numa_mode>] [-u <populate_mode>] [-x <indices_mode>] [-s <sample_interval_ms>] [-f <prefetch_distance>|auto] [-H <prefetch_hint>] [-S <stream_count>|all] [-A <alphabet_size>] [-P <partition_bits>|auto] [-B <batch_size>] [-L <latency_interval>] [-e <table_format>] [-C] [-U] [-F <output_format>] [-E] [-T <stream_chunk_size>] [-R <distribution>[:<params>]] [-Y <seed>] [-w] [-h]\n",
 			progname
 			);
-}
-
-static uint32_t round_to_pow_of_two(unsigned int value)
-{
-	unsigned int   rounded_value = value;
-	unsigned int   i;
-
-	for (i = 0; i < 32; ++i)
+	INFO("kernels: auto");
+	uint32_t                 kernel_count = 0;
+	const kernel_desc* const kernels = get_kernels(kernel_count);
+	for (uint32_t i = 0; i < kernel_count; ++i)
 	{
-		if (rounded_value & 0x80000000)
-		{
-			break;
-		}
-		rounded_value <<= 1;
+		fprintf(stdout, " %s", kernels[i].name);
 	}
-	rounded_value = 1 << (31 - i);
-	if (value > rounded_value)
+	fprintf(stdout, "\n");
+	INFO("load modes:");
+	print_value_names(stdout, LOAD_MODES);
+	fprintf(stdout, "\n");
+	INFO("table page modes:");
+	print_value_names(stdout, PAGE_MODES);
+	fprintf(stdout, "\n");
+	INFO("numa modes:");
+	print_value_names(stdout, NUMA_MODES);
+	fprintf(stdout, "\n");
+	INFO("populate modes:");
+	print_value_names(stdout, POPULATE_MODES);
+	fprintf(stdout, "\n");
+	INFO("generated distributions (zipf:<skew>, strided:<stride>, clustered:<size>:<length>):");
+	print_index_distributions(stdout);
+	fprintf(stdout, "\n");
+	INFO("indices modes:");
+	print_value_names(stdout, INDICES_MODES);
+	fprintf(stdout, "\n");
+	INFO("prefetch hints:");
+	print_value_names(stdout, PREFETCH_HINTS);
+	fprintf(stdout, "\n");
+	INFO("stream counts:");
+	for (const uint32_t stream_count : KERNEL_STREAM_COUNTS)
 	{
-		rounded_value <<= 1;
+		fprintf(stdout, " %u", stream_count);
 	}
-
-	return rounded_value;
+	fprintf(stdout, " all\n");
+	INFO("table formats:");
+	print_value_names(stdout, TABLE_FORMATS);
+	fprintf(stdout, "\n");
+	INFO("table reductions:");
+	print_value_names(stdout, TABLE_REDUCTIONS);
+	fprintf(stdout, "\n");
+	INFO("output formats:");
+	print_value_names(stdout, OUTPUT_FORMATS);
+	fprintf(stdout, "\n");
+	INFO("-F json|csv prints the results of each run to stdout and the other messages to stderr\n");
+	INFO("-D runs the passes over the indices for the given seconds instead of -c cycles\n");
+	INFO("-T streams %s of any size in chunks through all threads once, -i, -c, -D and -x do not apply\n", FILE_WITH_INDICES);
+	INFO("-E counts hardware events of each thread (needs perf_event_paranoid <= 2)\n");
+	INFO("-C converts %s to all table formats and exits\n", get_table_file_name(table_format::u16));
+	INFO("-U adds headers to legacy raw %s and table files and exits\n", FILE_WITH_INDICES);
+	INFO("without -e the table format is taken from the header of %s\n", get_table_file_name(table_format::u16));
 }
 
-template<typename T>
-static uint32_t get_buffer_size(const char* const str_value)
+/// Parses a table buffer size, powers of two are kept, other sizes are rounded up to TABLE_SIZE_ALIGNMENT.
+static uint64_t get_table_buffer_size(const char* const str_value)
 {
-	uint32_t value = (uint32_t)strtoul(str_value, nullptr, 10);
-	return round_to_pow_of_two(value);
+	const uint64_t value = strtoull(str_value, nullptr, 10);
+	if (value > TABLE_BUFFER_SIZE_MAX)
+	{
+		return 0;
+	}
+	return align_table_buffer_size(value);
 }
 
 static int parse_args(int argc, char *argv[], struct config& conf)
@@ -153,6 +399,162 @@ static int parse_args(int argc, char *argv[], struct config& conf)
 			/* flag */nullptr,
 			/* val */'d'
 		},
+		{
+			/* name */ "kernel",
+			/* has_arg */ya_required_argument,
+			/* flag */nullptr,
+			/* val */'k'
+		},
+		{
+			/* name */ "load-mode",
+			/* has_arg */ya_required_argument,
+			/* flag */nullptr,
+			/* val */'m'
+		},
+		{
+			/* name */ "table-pages",
+			/* has_arg */ya_required_argument,
+			/* flag */nullptr,
+			/* val */'p'
+		},
+		{
+			/* name */ "numa",
+			/* has_arg */ya_required_argument,
+			/* flag */nullptr,
+			/* val */'n'
+		},
+		{
+			/* name */ "populate",
+			/* has_arg */ya_required_argument,
+			/* flag */nullptr,
+			/* val */'u'
+		},
+		{
+			/* name */ "indices-mode",
+			/* has_arg */ya_required_argument,
+			/* flag */nullptr,
+			/* val */'x'
+		},
+		{
+			/* name */ "sample-interval",
+			/* has_arg */ya_required_argument,
+			/* flag */nullptr,
+			/* val */'s'
+		},
+		{
+			/* name */ "prefetch-distance",
+			/* has_arg */ya_required_argument,
+			/* flag */nullptr,
+			/* val */'f'
+		},
+		{
+			/* name */ "prefetch-hint",
+			/* has_arg */ya_required_argument,
+			/* flag */nullptr,
+			/* val */'H'
+		},
+		{
+			/* name */ "streams",
+			/* has_arg */ya_required_argument,
+			/* flag */nullptr,
+			/* val */'S'
+		},
+		{
+			/* name */ "alphabet-size",
+			/* has_arg */ya_required_argument,
+			/* flag */nullptr,
+			/* val */'A'
+		},
+		{
+			/* name */ "partition-bits",
+			/* has_arg */ya_required_argument,
+			/* flag */nullptr,
+			/* val */'P'
+		},
+		{
+			/* name */ "batch-size",
+			/* has_arg */ya_required_argument,
+			/* flag */nullptr,
+			/* val */'B'
+		},
+		{
+			/* name */ "latency-interval",
+			/* has_arg */ya_required_argument,
+			/* flag */nullptr,
+			/* val */'L'
+		},
+		{
+			/* name */ "table-reduction",
+			/* has_arg */ya_required_argument,
+			/* flag */nullptr,
+			/* val */'M'
+		},
+		{
+			/* name */ "table-format",
+			/* has_arg */ya_required_argument,
+			/* flag */nullptr,
+			/* val */'e'
+		},
+		{
+			/* name */ "convert-table",
+			/* has_arg */ya_no_argument,
+			/* flag */nullptr,
+			/* val */'C'
+		},
+		{
+			/* name */ "format",
+			/* has_arg */ya_required_argument,
+			/* flag */nullptr,
+			/* val */'F'
+		},
+		{
+			/* name */ "warmup-cycle-count",
+			/* has_arg */ya_required_argument,
+			/* flag */nullptr,
+			/* val */'W'
+		},
+		{
+			/* name */ "duration",
+			/* has_arg */ya_required_argument,
+			/* flag */nullptr,
+			/* val */'D'
+		},
+		{
+			/* name */ "perf-counters",
+			/* has_arg */ya_no_argument,
+			/* flag */nullptr,
+			/* val */'E'
+		},
+		{
+			/* name */ "stream-chunk-size",
+			/* has_arg */ya_required_argument,
+			/* flag */nullptr,
+			/* val */'T'
+		},
+		{
+			/* name */ "generate",
+			/* has_arg */ya_required_argument,
+			/* flag */nullptr,
+			/* val */'R'
+		},
+		{
+			/* name */ "seed",
+			/* has_arg */ya_required_argument,
+			/* flag */nullptr,
+			/* val */'Y'
+		},
+		{
+			/* name */ "write-files",
+			/* has_arg */ya_no_argument,
+			/* flag */nullptr,
+			/* val */'w'
+		},
+		{
+			/* name */ "upgrade-files",
+			/* has_arg */ya_no_argument,
+			/* flag */nullptr,
+			/* val */'U'
+		},
 		{
 			/* name */ "help",
 			/* has_arg */ya_no_argument,
@@ -170,164 +572,1466 @@ static int parse_args(int argc, char *argv[], struct config& conf)
 	ya_context ya_getopt_context;
 	ya_context_initx(&ya_getopt_context);
 
-	int longindex = 0;
-	int optopt = 0;
-	while ((optopt = ya_getopt_long(&ya_getopt_context, argc, argv, "l:i:t:c:d:a:b:e:gVh", longopts, &longindex)) != -1)
+	int  longindex = 0;
+	int  optopt = 0;
+	bool prefetch_given = false;
+	bool streams_given = false;
+	bool alphabet_given = false;
+	bool partition_given = false;
+	bool latency_given = false;
+	bool format_given = false;
+	bool reduction_given = false;
+	while ((optopt = ya_getopt_long(&ya_getopt_context, argc, argv, "l:i:t:M:c:W:D:d:k:m:p:n:u:x:s:f:H:S:A:P:B:L:e:CUF:ET:R:Y:wa:b:gVh", longopts, &longindex)) != -1)
 	{
 		switch (optopt)
 		{
 			case 'l':
+				if (strlen(ya_getopt_context.ya_optarg) >= sizeof(conf.location_of_files))
+				{
+					ERR("location of files too long\n");
+					return -1;
+				}
 				strcpy(conf.location_of_files, ya_getopt_context.ya_optarg);
 				break;
 
 			case 'i':
-				conf.indices_buffer_size = get_buffer_size<uint32_t>(ya_getopt_context.ya_optarg);
+				conf.indices_buffer_size = (uint32_t)get_buffer_size(ya_getopt_context.ya_optarg, INDICES_BUFFER_SIZE_MAX);
+				if (!conf.indices_buffer_size)
+				{
+					ERR("invalid indices buffer size %s\n", ya_getopt_context.ya_optarg);
+					return -1;
+				}
 				break;
 
 			case 't':
-				conf.table_buffer_size = get_buffer_size<uint16_t>(ya_getopt_context.ya_optarg);
+				conf.table_buffer_size = get_table_buffer_size(ya_getopt_context.ya_optarg);
+				if (conf.table_buffer_size < TABLE_ELEMENT_SIZE)
+				{
+					ERR("invalid table buffer size %s\n", ya_getopt_context.ya_optarg);
+					return -1;
+				}
 				break;
 
 			case 'c':
 				conf.cycle_count = (uint32_t)strtoul(ya_getopt_context.ya_optarg, nullptr, 10);
 				break;
 
+			case 'W':
+				conf.warmup_cycle_count = (uint32_t)strtoul(ya_getopt_context.ya_optarg, nullptr, 10);
+				break;
+
+			case 'D':
+				conf.duration = strtod(ya_getopt_context.ya_optarg, nullptr);
+				if (!(conf.duration > 0.0))
+				{
+					ERR("invalid duration %s\n", ya_getopt_context.ya_optarg);
+					return -1;
+				}
+				break;
+
 			case 'd':
 				conf.thread_count = (uint32_t)strtoul(ya_getopt_context.ya_optarg, nullptr, 10);
+				if (!conf.thread_count || conf.thread_count > THREADS_MAX)
+				{
+					ERR("invalid thread count %s, 1 to %u threads are supported\n", ya_getopt_context.ya_optarg, THREADS_MAX);
+					return -1;
+				}
 				break;
 
-			case 'h':
-				print_usage(argv[0]);
-				return -1;
+			case 'k':
+				if (strcmp(ya_getopt_context.ya_optarg, "auto") == 0)
+				{
+					conf.kernel = nullptr;
+					break;
+				}
+				conf.kernel = find_kernel(ya_getopt_context.ya_optarg);
+				if (!conf.kernel)
+				{
+					ERR("unknown kernel %s\n", ya_getopt_context.ya_optarg);
+					return -1;
+				}
+				break;
 
-			default:
-				return -1;
-		}
-	}
+			case 'm':
+				if (parse_named_value(LOAD_MODES, ya_getopt_context.ya_optarg, conf.load) < 0)
+				{
+					ERR("unknown load mode %s\n", ya_getopt_context.ya_optarg);
+					return -1;
+				}
+				break;
 
-	if (!conf.location_of_files[0])
-	{
-		ERR("location of files not given\n");
-		return -1;
-	}
+			case 'p':
+				if (parse_named_value(PAGE_MODES, ya_getopt_context.ya_optarg, conf.table_pages) < 0)
+				{
+					ERR("unknown table page mode %s\n", ya_getopt_context.ya_optarg);
+					return -1;
+				}
+				break;
 
-	conf.table_index_mask = conf.table_buffer_size / TABLE_ELEMENT_SIZE - 1;
+			case 'n':
+				if (parse_named_value(NUMA_MODES, ya_getopt_context.ya_optarg, conf.numa) < 0)
+				{
+					ERR("unknown numa mode %s\n", ya_getopt_context.ya_optarg);
+					return -1;
+				}
+				break;
 
-	INFO("location of files : %s\n", conf.location_of_files);
-	INFO("indices buffer size: %u\n", conf.indices_buffer_size);
-	INFO("table_buffer_size : %u\n", conf.table_buffer_size);
-	INFO("table_index_mask : 0x%08X\n", conf.table_index_mask);
+			case 'u':
+				if (parse_named_value(POPULATE_MODES, ya_getopt_context.ya_optarg, conf.populate) < 0)
+				{
+					ERR("unknown populate mode %s\n", ya_getopt_context.ya_optarg);
+					return -1;
+				}
+				break;
 
-	return 0;
-}
+			case 'x':
+				if (parse_named_value(INDICES_MODES, ya_getopt_context.ya_optarg, conf.indices) < 0)
+				{
+					ERR("unknown indices mode %s\n", ya_getopt_context.ya_optarg);
+					return -1;
+				}
+				break;
 
-template<typename T>
-static T* read_input_buffer(const char* const location, const char* const filename, uint32_t size)
-{
-	char path[2048];
-	snprintf(path, sizeof(path) - 1, "%s/%s", location, filename);
-	struct stat statbuf;
-	if (stat(path, &statbuf) < 0)
-	{
-		ERR("stat(%s) failed\n", path);
-		return nullptr;
-	}
-	if (statbuf.st_size < size)
-	{
-		ERR("size of file %s is lower then expected %u\n", path, size);
-		return nullptr;
-	}
-	const int fd = open(path, O_RDONLY);
-	if (fd < 0)
-	{
-		ERR("open(%s) failed\n", path);
-		return nullptr;
-	}
-	T* input = (T*)malloc(size);
-	if (!input)
-	{
-		ERR("malloc failed for %s\n", path);
-		close(fd);
-		return nullptr;
-	}
-	if (read(fd, input, size) != size)
-	{
-		close(fd);
-		free(input);
-		return nullptr;
-	}
-	close(fd);
+			case 's':
+				conf.sample_interval = (uint32_t)strtoul(ya_getopt_context.ya_optarg, nullptr, 10);
+				break;
 
-	return input;
-}
+			case 'f':
+				prefetch_given = true;
+				if (strcmp(ya_getopt_context.ya_optarg, "auto") == 0)
+				{
+					conf.prefetch_distance = PREFETCH_DISTANCE_AUTO;
+					break;
+				}
+				conf.prefetch_distance = (uint32_t)strtoul(ya_getopt_context.ya_optarg, nullptr, 10);
+				break;
 
-template<typename T>
-static void free_input_buffer(T* buffer)
+			case 'H':
+				prefetch_given = true;
+				if (parse_named_value(PREFETCH_HINTS, ya_getopt_context.ya_optarg, conf.prefetch) < 0)
+				{
+					ERR("unknown prefetch hint %s\n", ya_getopt_context.ya_optarg);
+					return -1;
+				}
+				break;
+
+			case 'S':
+			{
+				streams_given = true;
+				if (strcmp(ya_getopt_context.ya_optarg, "all") == 0)
+				{
+					conf.stream_count = STREAM_COUNT_ALL;
+					break;
+				}
+				conf.stream_count = (uint32_t)strtoul(ya_getopt_context.ya_optarg, nullptr, 10);
+				const uint32_t* const end = KERNEL_STREAM_COUNTS + sizeof(KERNEL_STREAM_COUNTS) / sizeof(KERNEL_STREAM_COUNTS[0]);
+				if (std::find(KERNEL_STREAM_COUNTS, end, conf.stream_count) == end)
+				{
+					ERR("unsupported stream count %s\n", ya_getopt_context.ya_optarg);
+					return -1;
+				}
+				break;
+			}
+
+			case 'A':
+				alphabet_given = true;
+				conf.alphabet_size = (uint32_t)strtoul(ya_getopt_context.ya_optarg, nullptr, 10);
+				if (!conf.alphabet_size || (conf.alphabet_size & (conf.alphabet_size - 1)))
+				{
+					ERR("alphabet size %s is not a power of two\n", ya_getopt_context.ya_optarg);
+					return -1;
+				}
+				break;
+
+			case 'P':
+				partition_given = true;
+				if (strcmp(ya_getopt_context.ya_optarg, "auto") == 0)
+				{
+					conf.partition_bits = PARTITION_BITS_AUTO;
+					break;
+				}
+				conf.partition_bits = (uint32_t)strtoul(ya_getopt_context.ya_optarg, nullptr, 10);
+				if (conf.partition_bits > PARTITION_BITS_MAX)
+				{
+					ERR("partition bits %s exceed %u\n", ya_getopt_context.ya_optarg, PARTITION_BITS_MAX);
+					return -1;
+				}
+				break;
+
+			case 'B':
+				partition_given = true;
+				conf.batch_size = (uint32_t)strtoul(ya_getopt_context.ya_optarg, nullptr, 10);
+				if (!conf.batch_size)
+				{
+					ERR("invalid batch size %s\n", ya_getopt_context.ya_optarg);
+					return -1;
+				}
+				break;
+
+			case 'L':
+				latency_given = true;
+				conf.latency_interval = (uint32_t)strtoul(ya_getopt_context.ya_optarg, nullptr, 10);
+				if (!conf.latency_interval)
+				{
+					ERR("invalid latency interval %s\n", ya_getopt_context.ya_optarg);
+					return -1;
+				}
+				break;
+
+			case 'e':
+				if (parse_named_value(TABLE_FORMATS, ya_getopt_context.ya_optarg, conf.format) < 0)
+				{
+					ERR("unknown table format %s\n", ya_getopt_context.ya_optarg);
+					return -1;
+				}
+				format_given = true;
+				break;
+
+			case 'M':
+				if (parse_named_value(TABLE_REDUCTIONS, ya_getopt_context.ya_optarg, conf.reduction) < 0)
+				{
+					ERR("unknown table reduction %s\n", ya_getopt_context.ya_optarg);
+					return -1;
+				}
+				reduction_given = true;
+				break;
+
+			case 'C':
+				conf.convert_table = true;
+				break;
+
+			case 'U':
+				conf.upgrade_files = true;
+				break;
+
+			case 'F':
+				if (parse_named_value(OUTPUT_FORMATS, ya_getopt_context.ya_optarg, conf.output) < 0)
+				{
+					ERR("unknown output format %s\n", ya_getopt_context.ya_optarg);
+					return -1;
+				}
+				break;
+
+			case 'E':
+				conf.perf = true;
+				break;
+
+			case 'T':
+				conf.stream_chunk_size = (uint32_t)get_buffer_size(ya_getopt_context.ya_optarg, UINT32_MAX);
+				if (conf.stream_chunk_size < sizeof(uint32_t))
+				{
+					ERR("invalid stream chunk size %s\n", ya_getopt_context.ya_optarg);
+					return -1;
+				}
+				break;
+
+			case 'R':
+				if (parse_generator_spec(ya_getopt_context.ya_optarg, conf.generator) < 0)
+				{
+					ERR("invalid distribution %s\n", ya_getopt_context.ya_optarg);
+					return -1;
+				}
+				conf.generate = true;
+				break;
+
+			case 'Y':
+				conf.generator.seed = strtoull(ya_getopt_context.ya_optarg, nullptr, 10);
+				break;
+
+			case 'w':
+				conf.write_files = true;
+				break;
+
+			case 'h':
+				print_usage(argv[0]);
+				return -1;
+
+			default:
+				return -1;
+		}
+	}
+
+	if (!conf.location_of_files[0] && (!conf.generate || conf.write_files))
+	{
+		ERR("location of files not given\n");
+		return -1;
+	}
+
+	if (conf.write_files && !conf.generate)
+	{
+		ERR("writing files needs a distribution to generate\n");
+		return -1;
+	}
+
+	if (conf.generate && (conf.stream_chunk_size || conf.populate != populate_mode::none || conf.convert_table || conf.upgrade_files))
+	{
+		ERR("generated buffers cannot be streamed, populated or converted\n");
+		return -1;
+	}
+
+	if (conf.generate)
+	{
+		format_generator_spec(conf.generator, conf.generator_spec, sizeof(conf.generator_spec));
+	}
+
+	if (conf.output != output_format::text)
+	{
+		info_stream = stderr;
+	}
+
+	const uint32_t cpu_features = detect_cpu_features();
+	char           cpu_features_str[128];
+	format_cpu_features(cpu_features, cpu_features_str, sizeof(cpu_features_str));
+	if (!conf.kernel)
+	{
+		conf.kernel = select_kernel(cpu_features);
+	}
+	else if ((conf.kernel->required_features & cpu_features) != conf.kernel->required_features)
+	{
+		ERR("kernel %s not supported by this CPU (features: %s)\n", conf.kernel->name, cpu_features_str);
+		return -1;
+	}
+
+	if (prefetch_given && !(conf.kernel->flags & KERNEL_FLAG_PREFETCH))
+	{
+		ERR("kernel %s does not prefetch\n", conf.kernel->name);
+		return -1;
+	}
+
+	if (streams_given && !(conf.kernel->flags & KERNEL_FLAG_STREAMS))
+	{
+		ERR("kernel %s does not use streams\n", conf.kernel->name);
+		return -1;
+	}
+
+	if (alphabet_given && !(conf.kernel->flags & KERNEL_FLAG_CHAIN))
+	{
+		ERR("kernel %s does not use alphabet\n", conf.kernel->name);
+		return -1;
+	}
+
+	if (partition_given && !(conf.kernel->flags & KERNEL_FLAG_PARTITION))
+	{
+		ERR("kernel %s does not partition indices\n", conf.kernel->name);
+		return -1;
+	}
+
+	if (latency_given && !(conf.kernel->flags & KERNEL_FLAG_LATENCY))
+	{
+		ERR("kernel %s does not time lookups\n", conf.kernel->name);
+		return -1;
+	}
+
+	if (conf.stream_chunk_size && conf.prefetch_distance == PREFETCH_DISTANCE_AUTO)
+	{
+		ERR("prefetch distance cannot be tuned without indices in memory\n");
+		return -1;
+	}
+
+	if (conf.stream_chunk_size && conf.thread_count * STREAM_BUFFERS_PER_THREAD > INDEX_STREAM_BUFFERS_MAX)
+	{
+		ERR("too many threads for streaming\n");
+		return -1;
+	}
+
+	if (conf.populate != populate_mode::none && (conf.numa != numa_mode::none || !is_load_to_buffer(conf.load)))
+	{
+		ERR("population of the table needs numa mode none and a load mode reading to a buffer\n");
+		return -1;
+	}
+
+	conf.table_file_name = get_table_file_name(conf.format);
+	if (!format_given && !conf.generate && !conf.convert_table && !conf.upgrade_files)
+	{
+		// The header tells the width of the elements, so the kernel specialized
+		// for it is selected without -e. Legacy table.bin holds u16 elements.
+		char         path[FILE_PATH_MAX];
+		file_payload payload;
+		if (get_data_file_path(path, sizeof(path), conf.location_of_files, conf.table_file_name) < 0)
+		{
+			return -1;
+		}
+		if (read_file_header(path, payload) < 0)
+		{
+			return -1;
+		}
+		if (payload.has_header)
+		{
+			if (payload.header.content != file_content::table || get_header_table_format(payload.header, conf.format) < 0)
+			{
+				ERR("%s does not hold a table of a known format\n", path);
+				return -1;
+			}
+			const uint32_t alphabet_size = payload.header.alphabet_size;
+			if ((conf.kernel->flags & KERNEL_FLAG_CHAIN) && !alphabet_given && alphabet_size && !(alphabet_size & (alphabet_size - 1)))
+			{
+				conf.alphabet_size = alphabet_size;
+			}
+		}
+	}
+
+	const uint64_t count_of_table_elements = conf.table_buffer_size / TABLE_ELEMENT_SIZE;
+	if (!reduction_given)
+	{
+		conf.reduction = get_default_reduction(count_of_table_elements);
+	}
+	if (init_table_indexing(conf.reduction, count_of_table_elements, conf.indexing) < 0)
+	{
+		return -1;
+	}
+	conf.wide_indices = needs_wide_indices(conf.format, count_of_table_elements);
+
+	const size_t table_size = get_table_size(conf.format, count_of_table_elements);
+	if (conf.partition_bits == PARTITION_BITS_AUTO)
+	{
+		conf.partition_bits = get_partition_bits(table_size);
+	}
+
+	INFO("location of files : %s\n", conf.location_of_files);
+	INFO("indices buffer size: %u\n", conf.indices_buffer_size);
+	INFO("table_buffer_size : %" PRIu64 "\n", conf.table_buffer_size);
+	INFO("table reduction : %s\n", get_value_name(TABLE_REDUCTIONS, conf.reduction));
+	if (conf.reduction == table_reduction::mask)
+	{
+		INFO("table_index_mask : 0x%08" PRIX64 "\n", conf.indexing.mask);
+	}
+	if (conf.wide_indices)
+	{
+		INFO("table indices : 64-bit, indices shifted by %u\n", conf.indexing.shift);
+	}
+	INFO("table format : %s (%zu bytes)\n", get_value_name(TABLE_FORMATS, conf.format), table_size);
+	cache_topology topology;
+	if (detect_cache_topology(topology) == 0)
+	{
+		cache_boundary              boundaries[CACHE_BOUNDARIES_MAX];
+		const uint32_t              boundary_count = get_cache_boundaries(topology, boundaries, CACHE_BOUNDARIES_MAX);
+		const cache_boundary* const level = find_cache_boundary(boundaries, boundary_count, table_size, boundary_kind::cache);
+		const cache_boundary* const stlb = find_cache_boundary(boundaries, boundary_count, 0, boundary_kind::tlb);
+		char                        boundaries_str[512];
+		format_cache_boundaries(boundaries, boundary_count, boundaries_str, sizeof(boundaries_str));
+		if (level)
+		{
+			snprintf(conf.cache_level, sizeof(conf.cache_level), "%s", level->name);
+		}
+		INFO("cache hierarchy : %s\n", boundaries_str);
+		INFO("table fits in : %s, STLB %s\n", conf.cache_level,
+				!stlb ? "unknown" : table_size <= stlb->size ? "yes" : "no");
+	}
+	if (!conf.generate)
+	{
+		INFO("table file : %s\n", conf.table_file_name);
+	}
+	INFO("cpu features : %s\n", cpu_features_str);
+	INFO("kernel : %s\n", conf.kernel->name);
+	INFO("load mode : %s\n", get_value_name(LOAD_MODES, conf.load));
+	INFO("table page mode : %s\n", get_value_name(PAGE_MODES, conf.table_pages));
+	INFO("numa mode : %s\n", get_value_name(NUMA_MODES, conf.numa));
+	INFO("populate mode : %s\n", get_value_name(POPULATE_MODES, conf.populate));
+	INFO("indices mode : %s\n", get_value_name(INDICES_MODES, conf.indices));
+	if (conf.generate)
+	{
+		INFO("generated distribution : %s, seed %" PRIu64 "\n", conf.generator_spec, conf.generator.seed);
+	}
+	INFO("warmup cycles : %u\n", conf.warmup_cycle_count);
+	if (conf.stream_chunk_size)
+	{
+		INFO("stream chunk size : %u\n", conf.stream_chunk_size);
+	}
+	if (conf.duration > 0.0)
+	{
+		INFO("duration : %.3f s\n", conf.duration);
+	}
+	if (conf.kernel->flags & KERNEL_FLAG_PREFETCH)
+	{
+		if (conf.prefetch_distance == PREFETCH_DISTANCE_AUTO)
+		{
+			INFO("prefetch distance : auto\n");
+		}
+		else
+		{
+			INFO("prefetch distance : %u\n", conf.prefetch_distance);
+		}
+		INFO("prefetch hint : %s\n", get_value_name(PREFETCH_HINTS, conf.prefetch));
+	}
+	if (conf.kernel->flags & KERNEL_FLAG_STREAMS)
+	{
+		if (conf.stream_count == STREAM_COUNT_ALL)
+		{
+			INFO("stream count : all\n");
+		}
+		else
+		{
+			INFO("stream count : %u\n", conf.stream_count);
+		}
+	}
+	if (conf.kernel->flags & KERNEL_FLAG_CHAIN)
+	{
+		INFO("alphabet size : %u\n", conf.alphabet_size);
+	}
+	if (conf.kernel->flags & KERNEL_FLAG_PARTITION)
+	{
+		INFO("partition bits : %u (%zu bytes per bucket)\n", conf.partition_bits, table_size >> conf.partition_bits);
+		INFO("batch size : %u\n", conf.batch_size);
+	}
+	if (conf.kernel->flags & KERNEL_FLAG_LATENCY)
+	{
+		INFO("latency interval : %u\n", conf.latency_interval);
+	}
+
+	return 0;
+}
+
+static void* thread_func(struct thread_data* thr_data)
+{
+	pin_thread(thr_data->id);
+
+	uint32_t* indices = thr_data->common_data->indices[thr_data->node] + thr_data->indices_first;
+	if (thr_data->private_indices)
+	{
+		// The copy is first touched here, so its pages are placed on the node of the thread.
+		memcpy(thr_data->private_indices, indices, thr_data->indices_count * sizeof(uint32_t));
+		indices = thr_data->private_indices;
+	}
+
+	struct config*        conf = thr_data->conf;
+	const kernel_func     kernel = conf->kernel->func;
+	const kernel_context  ctx =
+	{
+		/* indices */ indices,
+		/* table */ thr_data->common_data->table[thr_data->node],
+		/* format */ conf->format,
+		/* count_of_indices */ thr_data->indices_count,
+		/* indexing */ conf->indexing,
+		/* wide_indices */ conf->wide_indices,
+		/* thread_id */ thr_data->id,
+		/* prefetch_distance */ conf->prefetch_distance,
+		/* prefetch_locality */ conf->prefetch,
+		/* stream_count */ conf->stream_count,
+		/* alphabet_size */ conf->alphabet_size,
+		/* partition_bits */ conf->partition_bits,
+		/* batch_size */ conf->batch_size,
+		/* scratch */ thr_data->scratch,
+		/* latency_interval */ conf->latency_interval,
+		/* histogram */ &thr_data->histogram
+	};
+	thread_common_data* const common_data = thr_data->common_data;
+	if (!wait_for_start(common_data->start))
+	{
+		thr_data->live.finished.store(true, std::memory_order_release);
+		return nullptr;
+	}
+
+	for (uint32_t cycle = 0; cycle < conf->warmup_cycle_count; ++cycle)
+	{
+		kernel(ctx);
+	}
+	thr_data->histogram.reset();
+
+	uint16_t              value = 0;
+	uint32_t              cycles = 0;
+	uint64_t              table_accesses = 0;
+	double                kernel_time = 0.0;
+	struct timespec       start;
+	struct timespec       end;
+	perf_counters         counters;
+	if (conf->perf)
+	{
+		counters.open();
+	}
+	pthread_barrier_wait(&common_data->measure_barrier);
+	if (conf->perf)
+	{
+		counters.start();
+	}
+	const double duration_ms = conf->duration * 1000.0;
+	const uint64_t tsc_start = __rdtsc();
+	clock_gettime(CLOCK_MONOTONIC_RAW, &start);
+	end = start;
+	if (common_data->stream)
+	{
+		// All threads use thread id 0, so the value does not depend on which thread gets which chunk.
+		kernel_context chunk_ctx = ctx;
+		chunk_ctx.thread_id = 0;
+		index_chunk    chunk;
+		while (common_data->stream->acquire(chunk))
+		{
+			chunk_ctx.indices = chunk.indices;
+			chunk_ctx.count_of_indices = chunk.count;
+			struct timespec chunk_start;
+			struct timespec chunk_end;
+			clock_gettime(CLOCK_MONOTONIC_RAW, &chunk_start);
+			value ^= kernel(chunk_ctx);
+			clock_gettime(CLOCK_MONOTONIC_RAW, &chunk_end);
+			common_data->stream->release(chunk);
+
+			kernel_time += get_clockdiff_ms(&chunk_start, &chunk_end);
+			table_accesses += chunk.count;
+			thr_data->live.table_accesses.store(table_accesses, std::memory_order_relaxed);
+		}
+	}
+	else
+	{
+		while (duration_ms > 0.0 ? get_clockdiff_ms(&start, &end) < duration_ms : cycles < conf->cycle_count)
+		{
+			value ^= kernel(ctx);
+			cycles++;
+			table_accesses += ctx.count_of_indices;
+			thr_data->live.table_accesses.store(table_accesses, std::memory_order_relaxed);
+			if (duration_ms > 0.0)
+			{
+				clock_gettime(CLOCK_MONOTONIC_RAW, &end);
+			}
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC_RAW, &end);
+	thr_data->tsc_ticks = __rdtsc() - tsc_start;
+	if (conf->perf)
+	{
+		counters.stop();
+		thr_data->perf = counters.read();
+	}
+
+	thr_data->table_accesses = table_accesses;
+	// Streaming threads also wait for the reader, only the time in the kernel is comparable.
+	thr_data->clock_sum = common_data->stream ? kernel_time : get_clockdiff_ms(&start, &end);
+	thr_data->value = value;
+	thr_data->live.finished.store(true, std::memory_order_release);
+
+	return nullptr;
+}
+
+static void sample_live_counters(struct thread_data* const* thr_data, const uint32_t thread_count, const uint32_t interval)
+{
+	uint64_t        last_table_accesses[THREADS_MAX] = {};
+	struct timespec start;
+	struct timespec last;
+	clock_gettime(CLOCK_MONOTONIC_RAW, &start);
+	last = start;
+	bool finished = false;
+	while (!finished)
+	{
+		usleep(interval * 1000);
+
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+		const double dt = get_clockdiff_ms(&last, &now);
+		double       throughput_sum = 0.0;
+		double       throughput_min = 0.0;
+		double       throughput_max = 0.0;
+		finished = true;
+		for (uint32_t thread_id = 0; thread_id < thread_count; ++thread_id)
+		{
+			finished &= thr_data[thread_id]->live.finished.load(std::memory_order_acquire);
+			const uint64_t table_accesses = thr_data[thread_id]->live.table_accesses.load(std::memory_order_relaxed);
+			const double   throughput = ((table_accesses - last_table_accesses[thread_id]) / 1000.0) / dt;
+			last_table_accesses[thread_id] = table_accesses;
+			throughput_sum += throughput;
+			throughput_min = thread_id ? std::min(throughput_min, throughput) : throughput;
+			throughput_max = std::max(throughput_max, throughput);
+		}
+		last = now;
+		INFO("sample %.1f ms: THR sum %.4f MT/s, min %.4f MT/s, max %.4f MT/s\n",
+				get_clockdiff_ms(&start, &now), throughput_sum, throughput_min, throughput_max);
+	}
+}
+
+/** Measures the prefetch kernel with each of PREFETCH_DISTANCES_TUNED.
+ *
+ * @return The distance with the highest throughput.
+ */
+static uint32_t tune_prefetch_distance(
+		const struct config&  conf,
+		const uint32_t* const indices,
+		const uint32_t        count_of_indices,
+		const void* const     table)
+{
+	// Kernels modify the indices, so every distance starts from the same copy.
+	uint32_t* const scratch = (uint32_t*)malloc(count_of_indices * sizeof(uint32_t));
+	if (!scratch)
+	{
+		return PREFETCH_DISTANCE_DEFAULT;
+	}
+	auto free_scratch = scope_exit([&]() { free(scratch); });
+
+	uint32_t best_distance = PREFETCH_DISTANCE_DEFAULT;
+	double   best_throughput = 0.0;
+	for (const uint32_t distance : PREFETCH_DISTANCES_TUNED)
+	{
+		memcpy(scratch, indices, count_of_indices * sizeof(uint32_t));
+		const kernel_context ctx =
+		{
+			/* indices */ scratch,
+			/* table */ table,
+			/* format */ conf.format,
+			/* count_of_indices */ count_of_indices,
+			/* indexing */ conf.indexing,
+			/* wide_indices */ conf.wide_indices,
+			/* thread_id */ 0,
+			/* prefetch_distance */ distance,
+			/* prefetch_locality */ conf.prefetch,
+			/* stream_count */ conf.stream_count,
+			/* alphabet_size */ conf.alphabet_size,
+			/* partition_bits */ conf.partition_bits,
+			/* batch_size */ conf.batch_size,
+			/* scratch */ nullptr,
+			/* latency_interval */ conf.latency_interval,
+			/* histogram */ nullptr
+		};
+		struct timespec start;
+		struct timespec end;
+		clock_gettime(CLOCK_MONOTONIC_RAW, &start);
+		uint16_t value = 0;
+		for (uint32_t cycle = 0; cycle < PREFETCH_TUNE_CYCLES; ++cycle)
+		{
+			value ^= conf.kernel->func(ctx);
+		}
+		clock_gettime(CLOCK_MONOTONIC_RAW, &end);
+
+		const double throughput = ((PREFETCH_TUNE_CYCLES * (double)count_of_indices) / 1000.0) / get_clockdiff_ms(&start, &end);
+		INFO("prefetch distance %u: %.4f MT/s (value %u)\n", distance, throughput, value);
+		if (throughput > best_throughput)
+		{
+			best_throughput = throughput;
+			best_distance = distance;
+		}
+	}
+	INFO("best prefetch distance for table size %" PRIu64 ": %u\n", conf.table_buffer_size, best_distance);
+
+	return best_distance;
+}
+
+/// Results of one run aggregated over the threads.
+struct run_results
+{
+	uint64_t table_accesses = 0;
+
+	double   clock_sum = 0.0;
+
+	double   clock_sum_max = 0.0;
+
+	/// Data read and written in MB/s.
+	double   throughput = 0.0;
+
+	double   avg_per_thread = 0.0;
+
+	double   avg_all_threads = 0.0;
+
+	/// Table accesses of all threads divided by the time of the slowest thread.
+	double   slowest_thread = 0.0;
+
+	/// Sum of the throughputs of the threads.
+	double   throughput_sum = 0.0;
+
+	/// Time from the start of the threads to the end of the last one, including the reading of streamed indices.
+	double   wall_clock = 0.0;
+
+	/// Table accesses of all threads divided by wall_clock.
+	double   end_to_end = 0.0;
+
+	uint16_t value = 0;
+
+	/// Sums of the counters available in all threads.
+	perf_counter_values perf;
+
+	/// Merged histograms of the threads.
+	latency_histogram   histogram;
+
+	/// Time of a time stamp counter tick in ns.
+	double              ns_per_tick = 0.0;
+};
+
+/// Prints the counters available in @p perf as JSON members.
+static void print_perf_json(const perf_counter_values& perf)
+{
+	bool first = true;
+	for (uint32_t i = 0; i < PERF_COUNTER_COUNT; ++i)
+	{
+		if (perf.available & (1u << i))
+		{
+			fprintf(stdout, "%s\"%s\":%zu", first ? "" : ",", get_perf_counter_name((perf_counter)i), perf.values[i]);
+			first = false;
+		}
+	}
+}
+
+/// Prints the counters as CSV fields, each preceded by a comma, unavailable counters are empty.
+static void print_perf_csv(const perf_counter_values& perf)
+{
+	for (uint32_t i = 0; i < PERF_COUNTER_COUNT; ++i)
+	{
+		if (perf.available & (1u << i))
+		{
+			fprintf(stdout, ",%zu", perf.values[i]);
+		}
+		else
+		{
+			fprintf(stdout, ",");
+		}
+	}
+}
+
+/// Prints the results of the run as one JSON object on one line.
+static void print_results_json(
+		const struct config&             conf,
+		const struct thread_data* const* thr_data,
+		const uint32_t                   thread_count,
+		const run_results&               results)
+{
+	fprintf(stdout, "{\"kernel\":\"%s\",\"table_format\":\"%s\",\"indices_buffer_size\":%u,\"table_buffer_size\":%" PRIu64 ",\"table_reduction\":\"%s\",\"cache_level\":\"%s\","
+			"\"cycle_count\":%u,\"warmup_cycle_count\":%u,\"duration_s\":%.3f,\"thread_count\":%u,\"load_mode\":\"%s\",\"table_page_mode\":\"%s\",\"numa_mode\":\"%s\","
+			"\"populate_mode\":\"%s\",\"generator\":\"%s\",\"generator_seed\":%" PRIu64 ",\"indices_mode\":\"%s\",\"prefetch_distance\":%u,\"prefetch_hint\":\"%s\",\"stream_count\":%u,"
+			"\"alphabet_size\":%u,\"partition_bits\":%u,\"batch_size\":%u,\"stream_chunk_size\":%u,\"threads\":[",
+			conf.kernel->name, get_value_name(TABLE_FORMATS, conf.format), conf.indices_buffer_size, conf.table_buffer_size,
+			get_value_name(TABLE_REDUCTIONS, conf.reduction), conf.cache_level, conf.cycle_count, conf.warmup_cycle_count, conf.duration, conf.thread_count,
+			get_value_name(LOAD_MODES, conf.load), get_value_name(PAGE_MODES, conf.table_pages),
+			get_value_name(NUMA_MODES, conf.numa), get_value_name(POPULATE_MODES, conf.populate),
+			conf.generator_spec, conf.generator.seed, get_value_name(INDICES_MODES, conf.indices), conf.prefetch_distance,
+			get_value_name(PREFETCH_HINTS, conf.prefetch), conf.stream_count, conf.alphabet_size, conf.partition_bits, conf.batch_size,
+			conf.stream_chunk_size);
+	for (uint32_t thread_id = 0; thread_id < thread_count; ++thread_id)
+	{
+		fprintf(stdout, "%s{\"id\":%u,\"node\":%u,\"table_accesses\":%zu,\"clock_sum\":%.4f,\"value\":%u",
+				thread_id ? "," : "", thread_id, thr_data[thread_id]->node,
+				thr_data[thread_id]->table_accesses, thr_data[thread_id]->clock_sum, thr_data[thread_id]->value);
+		if (conf.perf)
+		{
+			fprintf(stdout, ",\"perf\":{");
+			print_perf_json(thr_data[thread_id]->perf);
+			fprintf(stdout, "}");
+		}
+		fprintf(stdout, "}");
+	}
+	fprintf(stdout, "],\"table_accesses\":%zu,\"clock_sum\":%.4f,\"clock_sum_max\":%.4f,\"throughput_mb_s\":%.4f,"
+			"\"avg_per_thread_mt_s\":%.4f,\"avg_all_threads_mt_s\":%.4f,\"slowest_thread_mt_s\":%.4f,\"thr_sum_mt_s\":%.4f,"
+			"\"wall_clock\":%.4f,\"end_to_end_mt_s\":%.4f,\"value\":%u",
+			results.table_accesses, results.clock_sum, results.clock_sum_max, results.throughput,
+			results.avg_per_thread, results.avg_all_threads, results.slowest_thread, results.throughput_sum,
+			results.wall_clock, results.end_to_end, results.value);
+	if (conf.perf)
+	{
+		fprintf(stdout, ",\"perf\":{");
+		print_perf_json(results.perf);
+		fprintf(stdout, "}");
+	}
+	if (conf.kernel->flags & KERNEL_FLAG_LATENCY)
+	{
+		fprintf(stdout, ",\"latency\":{\"samples\":%zu,\"ns_per_tick\":%.6f,\"min\":%zu",
+				results.histogram.get_count(), results.ns_per_tick, results.histogram.get_min());
+		for (const double percentile : LATENCY_PERCENTILES)
+		{
+			fprintf(stdout, ",\"p%g\":%zu", percentile, results.histogram.get_percentile(percentile));
+		}
+		fprintf(stdout, ",\"max\":%zu}", results.histogram.get_max());
+	}
+	fprintf(stdout, "}\n");
+	fflush(stdout);
+}
+
+/** Prints the results of the run as one CSV line per thread.
+ *
+ * Every line repeats the configuration and the aggregated results, so the
+ * lines can be loaded without joining.
+ *
+ * @param run_index Index of the run in the process, the header is printed before the first run.
+ */
+static void print_results_csv(
+		const struct config&             conf,
+		const struct thread_data* const* thr_data,
+		const uint32_t                   thread_count,
+		const run_results&               results,
+		const uint32_t                   run_index)
 {
-	if (buffer)
+	if (!run_index)
+	{
+		fprintf(stdout, "run,kernel,table_format,indices_buffer_size,table_buffer_size,table_reduction,cache_level,cycle_count,warmup_cycle_count,duration_s,thread_count,"
+				"load_mode,table_page_mode,numa_mode,populate_mode,generator,generator_seed,indices_mode,prefetch_distance,prefetch_hint,stream_count,"
+				"alphabet_size,partition_bits,batch_size,stream_chunk_size,thread_id,node,thread_table_accesses,thread_clock_sum,"
+				"thread_value,table_accesses,clock_sum,clock_sum_max,throughput_mb_s,avg_per_thread_mt_s,"
+				"avg_all_threads_mt_s,slowest_thread_mt_s,thr_sum_mt_s,wall_clock,end_to_end_mt_s,value");
+		if (conf.perf)
+		{
+			// Counters of the thread followed by the sums over the threads.
+			for (const char* prefix : { "thread_", "" })
+			{
+				for (uint32_t i = 0; i < PERF_COUNTER_COUNT; ++i)
+				{
+					fprintf(stdout, ",%s%s", prefix, get_perf_counter_name((perf_counter)i));
+				}
+			}
+		}
+		if (conf.kernel->flags & KERNEL_FLAG_LATENCY)
+		{
+			fprintf(stdout, ",latency_samples,latency_ns_per_tick,latency_min");
+			for (const double percentile : LATENCY_PERCENTILES)
+			{
+				fprintf(stdout, ",latency_p%g", percentile);
+			}
+			fprintf(stdout, ",latency_max");
+		}
+		fprintf(stdout, "\n");
+	}
+	for (uint32_t thread_id = 0; thread_id < thread_count; ++thread_id)
+	{
+		fprintf(stdout, "%u,%s,%s,%u,%" PRIu64 ",%s,%s,%u,%u,%.3f,%u,%s,%s,%s,%s,%s,%" PRIu64 ",%s,%u,%s,%u,%u,%u,%u,%u,%u,%u,%zu,%.4f,%u,%zu,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%u",
+				run_index, conf.kernel->name, get_value_name(TABLE_FORMATS, conf.format), conf.indices_buffer_size,
+				conf.table_buffer_size, get_value_name(TABLE_REDUCTIONS, conf.reduction), conf.cache_level, conf.cycle_count,
+				conf.warmup_cycle_count, conf.duration, conf.thread_count, get_value_name(LOAD_MODES, conf.load),
+				get_value_name(PAGE_MODES, conf.table_pages), get_value_name(NUMA_MODES, conf.numa),
+				get_value_name(POPULATE_MODES, conf.populate), conf.generator_spec, conf.generator.seed,
+				get_value_name(INDICES_MODES, conf.indices), conf.prefetch_distance,
+				get_value_name(PREFETCH_HINTS, conf.prefetch), conf.stream_count, conf.alphabet_size,
+				conf.partition_bits, conf.batch_size, conf.stream_chunk_size, thread_id, thr_data[thread_id]->node,
+				thr_data[thread_id]->table_accesses, thr_data[thread_id]->clock_sum, thr_data[thread_id]->value,
+				results.table_accesses, results.clock_sum, results.clock_sum_max, results.throughput,
+				results.avg_per_thread, results.avg_all_threads, results.slowest_thread, results.throughput_sum,
+				results.wall_clock, results.end_to_end, results.value);
+		if (conf.perf)
+		{
+			print_perf_csv(thr_data[thread_id]->perf);
+			print_perf_csv(results.perf);
+		}
+		if (conf.kernel->flags & KERNEL_FLAG_LATENCY)
+		{
+			fprintf(stdout, ",%zu,%.6f,%zu", results.histogram.get_count(), results.ns_per_tick, results.histogram.get_min());
+			for (const double percentile : LATENCY_PERCENTILES)
+			{
+				fprintf(stdout, ",%zu", results.histogram.get_percentile(percentile));
+			}
+			fprintf(stdout, ",%zu", results.histogram.get_max());
+		}
+		fprintf(stdout, "\n");
+	}
+	fflush(stdout);
+}
+
+/** Runs the test once - creates the threads, waits for them and prints the results.
+ *
+ * @param run_index Index of the run in the process.
+ * @param value     Output for the value computed by the threads.
+ *
+ * @return 0 on success, -1 if not all threads could be created.
+ */
+static int run_threads(
+		struct config&             conf,
+		struct thread_common_data& thr_common_data,
+		const numa_topology&       topology,
+		const uint32_t             run_index,
+		uint16_t&                  value)
+{
+	const uint32_t            count_of_input_indices = thr_common_data.count_of_input_indices;
+	struct thread_data*       thr_data[THREADS_MAX] = {};
+	input_buffer              thread_data_memory[THREADS_MAX];
+	input_buffer              thread_indices[THREADS_MAX];
+	input_buffer              thread_scratch[THREADS_MAX];
+	pthread_attr_t            thread_attr;
+	pthread_attr_init(&thread_attr);
+	pthread_t                 threads[THREADS_MAX] = {};
+	uint32_t                  thread_count = 0;
+	close_start_gate(thr_common_data.start);
+	pthread_barrier_init(&thr_common_data.measure_barrier, nullptr, conf.thread_count);
+	auto destroy_barrier = scope_exit([&]() { pthread_barrier_destroy(&thr_common_data.measure_barrier); });
+	for (uint32_t thread_id = 0; thread_id < conf.thread_count; ++thread_id)
+	{
+		uint32_t node = thread_id < NUMA_CPUS_MAX ? topology.cpu_node[thread_id] : topology.nodes[0];
+		if (!thr_common_data.table[node])
+		{
+			node = topology.nodes[0];
+		}
+
+		// Data of each thread are on the node of the thread, so the writes of
+		// the results and the live counters do not cross nodes.
+		size_t      mapped_size;
+		void* const memory = allocate_on_node(sizeof(thread_data), node, mapped_size);
+		if (!memory)
+		{
+			break;
+		}
+		thread_data_memory[thread_id] = input_buffer::from_mapping(memory, sizeof(thread_data), mapped_size);
+		struct thread_data* const data = new (memory) thread_data();
+		thr_data[thread_id] = data;
+
+		data->conf = &conf;
+		data->common_data = &thr_common_data;
+		data->id = thread_id;
+		data->node = node;
+		data->indices_count = count_of_input_indices;
+		if (conf.indices == indices_mode::slice)
+		{
+			data->indices_count = count_of_input_indices / conf.thread_count;
+			data->indices_first = data->indices_count * thread_id;
+		}
+		if (conf.indices != indices_mode::shared && !thr_common_data.stream)
+		{
+			const size_t size = data->indices_count * sizeof(uint32_t);
+			page_mode    obtained;
+			void* const  indices = allocate_pages(size, page_mode::normal, obtained, mapped_size);
+			if (!indices)
+			{
+				break;
+			}
+			thread_indices[thread_id] = input_buffer::from_mapping(indices, size, mapped_size);
+			data->private_indices = thread_indices[thread_id].get<uint32_t>();
+		}
+		if (conf.kernel->flags & KERNEL_FLAG_PARTITION)
+		{
+			const size_t size = get_partition_scratch_count(conf.batch_size, conf.partition_bits) * sizeof(uint32_t);
+			page_mode    obtained;
+			void* const  scratch = allocate_pages(size, page_mode::normal, obtained, mapped_size);
+			if (!scratch)
+			{
+				break;
+			}
+			thread_scratch[thread_id] = input_buffer::from_mapping(scratch, size, mapped_size);
+			data->scratch = thread_scratch[thread_id].get<uint32_t>();
+		}
+		if (pthread_create(
+				&threads[thread_id],
+				&thread_attr,
+				(void*(*)(void*))thread_func,
+				(void*)data) != 0)
+		{
+			break;
+		}
+		thread_count++;
+	}
+
+	bool stream_failed = false;
+	if (thr_common_data.stream && thread_count == conf.thread_count && thr_common_data.stream->start() < 0)
+	{
+		ERR("failed to start reading of indices\n");
+		stream_failed = true;
+	}
+
+	// Threads are released once all of them exist, so none of them runs alone.
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC_RAW, &start);
+	open_start_gate(thr_common_data.start, thread_count < conf.thread_count || stream_failed);
+
+	if (conf.sample_interval && !thr_common_data.start.aborted)
+	{
+		sample_live_counters(thr_data, thread_count, conf.sample_interval);
+	}
+
+	for (uint32_t thread_id = 0; thread_id < thread_count; ++thread_id)
+	{
+		pthread_join(threads[thread_id], nullptr);
+	}
+	struct timespec end;
+	clock_gettime(CLOCK_MONOTONIC_RAW, &end);
+	if (thr_common_data.stream)
+	{
+		thr_common_data.stream->stop();
+	}
+
+	if (thread_count < conf.thread_count)
+	{
+		// Not all threads were created, so the test is irrelevant.
+		ERR("created only %u of %u threads\n", thread_count, conf.thread_count);
+		return -1;
+	}
+	if (stream_failed)
+	{
+		return -1;
+	}
+
+	uint64_t table_accesses = 0;
+	value = 0;
+	double clock_sum = 0.0;
+	double clock_sum_max = 0.0;
+	double throughput_sum = 0.0;
+	for (uint32_t thread_id = 0; thread_id < thread_count; ++thread_id)
+	{
+		table_accesses += thr_data[thread_id]->table_accesses;
+		clock_sum += thr_data[thread_id]->clock_sum;
+		clock_sum_max = std::max(clock_sum_max, thr_data[thread_id]->clock_sum);
+		// Streamed chunks go to any of the threads, XOR of the values does not depend on that.
+		value = thr_common_data.stream ? value ^ thr_data[thread_id]->value : value + thr_data[thread_id]->value;
+		if (thr_data[thread_id]->clock_sum > 0.0)
+		{
+			throughput_sum += ((thr_data[thread_id]->table_accesses / 1000.0) / thr_data[thread_id]->clock_sum);
+		}
+	}
+	uint64_t table_accesses_avg = table_accesses / thread_count;
+	double clock_sum_avg = clock_sum / (double)thread_count;
+
+	run_results results;
+	results.table_accesses = table_accesses;
+	results.clock_sum = clock_sum;
+	results.clock_sum_max = clock_sum_max;
+	results.avg_per_thread = (table_accesses_avg / 1000.0) / clock_sum_avg;
+	results.avg_all_threads = (table_accesses / 1000.0) / clock_sum;
+	results.slowest_thread = (table_accesses / 1000.0) / clock_sum_max;
+	results.throughput_sum = throughput_sum;
+	results.wall_clock = get_clockdiff_ms(&start, &end);
+	results.end_to_end = (table_accesses / 1000.0) / results.wall_clock;
+	results.value = value;
+
+	INFO("table accesses: %zu\n", table_accesses);
+	INFO("clockdiff: %.4f ms\n", clock_sum);
+	const double data_read_written = table_accesses * get_table_element_bits(conf.format) / 8.0;
+	results.throughput = (data_read_written / 1000.0) / clock_sum;
+	INFO("data_read_written: %.4f\n", data_read_written);
+	INFO("throughput: %.4f MB/s\n", results.throughput);
+	INFO("transactions: AVG per thread %.4f MT/s (a=%zu dt=%.4f), AVG all threads %.4f MT/s (a=%zu dt=%.4f), %.4f MT/s (a=%zu dt=%.4f) THR sum %.4f MT/s\n",
+			results.avg_per_thread, table_accesses_avg, clock_sum_avg,
+			results.avg_all_threads, table_accesses, clock_sum,
+			results.slowest_thread, table_accesses, clock_sum_max,
+			throughput_sum);
+	INFO("value: %u\n", value);
+
+	if (thr_common_data.stream)
+	{
+		const index_stream& stream = *thr_common_data.stream;
+		if (stream.has_failed())
+		{
+			ERR("reading of indices failed\n");
+			return -1;
+		}
+		INFO("stream: read %zu of %zu bytes in %.4f ms (%.4f MB/s)\n",
+				stream.get_bytes_read(), stream.get_file_size(), stream.get_read_time(),
+				(stream.get_bytes_read() / 1000.0) / stream.get_read_time());
+		INFO("end-to-end: %.4f MT/s (a=%zu dt=%.4f), kernel only THR sum %.4f MT/s\n",
+				results.end_to_end, table_accesses, results.wall_clock, throughput_sum);
+	}
+
+	if (conf.perf)
+	{
+		results.perf = thr_data[0]->perf;
+		for (uint32_t thread_id = 1; thread_id < thread_count; ++thread_id)
+		{
+			results.perf += thr_data[thread_id]->perf;
+		}
+		if (!results.perf.available)
+		{
+			INFO("perf counters: not available\n");
+		}
+		for (uint32_t i = 0; i < PERF_COUNTER_COUNT; ++i)
+		{
+			if (results.perf.available & (1u << i))
+			{
+				INFO("perf %s: %zu (%.4f per access)\n",
+						get_perf_counter_name((perf_counter)i), results.perf.values[i],
+						(double)results.perf.values[i] / table_accesses);
+			}
+		}
+		const uint32_t ipc_counters = (1u << PERF_COUNTER_CYCLES) | (1u << PERF_COUNTER_INSTRUCTIONS);
+		if ((results.perf.available & ipc_counters) == ipc_counters && results.perf.values[PERF_COUNTER_CYCLES])
+		{
+			INFO("perf IPC: %.4f\n",
+					(double)results.perf.values[PERF_COUNTER_INSTRUCTIONS] / results.perf.values[PERF_COUNTER_CYCLES]);
+		}
+	}
+
+	if (conf.kernel->flags & KERNEL_FLAG_LATENCY)
+	{
+		uint64_t tsc_ticks = 0;
+		for (uint32_t thread_id = 0; thread_id < thread_count; ++thread_id)
+		{
+			results.histogram.merge(thr_data[thread_id]->histogram);
+			tsc_ticks += thr_data[thread_id]->tsc_ticks;
+		}
+		results.ns_per_tick = tsc_ticks ? clock_sum * 1000000.0 / tsc_ticks : 0.0;
+		INFO("latency samples: %zu, min %zu ticks (%.1f ns), max %zu ticks (%.1f ns)\n",
+				results.histogram.get_count(),
+				results.histogram.get_min(), results.histogram.get_min() * results.ns_per_tick,
+				results.histogram.get_max(), results.histogram.get_max() * results.ns_per_tick);
+		for (const double percentile : LATENCY_PERCENTILES)
+		{
+			const uint64_t latency = results.histogram.get_percentile(percentile);
+			INFO("latency p%g: %zu ticks (%.1f ns)\n", percentile, latency, latency * results.ns_per_tick);
+		}
+	}
+
+	if (conf.output == output_format::json)
+	{
+		print_results_json(conf, thr_data, thread_count, results);
+	}
+	else if (conf.output == output_format::csv)
 	{
-		free((void*)buffer);
+		print_results_csv(conf, thr_data, thread_count, results, run_index);
+	}
+
+	for (uint32_t i = 0; i < topology.node_count; ++i)
+	{
+		const uint32_t node = topology.nodes[i];
+		uint32_t       node_thread_count = 0;
+		double         node_throughput_sum = 0.0;
+		for (uint32_t thread_id = 0; thread_id < thread_count; ++thread_id)
+		{
+			if (thr_data[thread_id]->node == node)
+			{
+				node_thread_count++;
+				node_throughput_sum += thr_data[thread_id]->clock_sum > 0.0 ?
+						((thr_data[thread_id]->table_accesses / 1000.0) / thr_data[thread_id]->clock_sum) : 0.0;
+			}
+		}
+		if (node_thread_count)
+		{
+			INFO("node %u: threads %u, THR sum %.4f MT/s\n", node, node_thread_count, node_throughput_sum);
+		}
 	}
+
+	return 0;
 }
 
-static double get_clockdiff_ms(struct timespec *start, struct timespec *end)
+/** Writes a buffer to a data file with a header.
+ *
+ * @param element_bits  Count of bits of an element.
+ * @param element_count Count of elements in @p data.
+ * @param alphabet_size Count of symbols per state of a table, 0 for indices.
+ *
+ * @return 0 on success, -1 on failure.
+ */
+static int write_file(
+		const char*  location,
+		const char*  filename,
+		file_content content,
+		uint32_t     element_bits,
+		uint64_t     element_count,
+		uint32_t     alphabet_size,
+		const void*  data,
+		size_t       size)
 {
-	return ((double)end->tv_nsec/1000000.0 + (double)end->tv_sec*1000.0) -
-			((double)start->tv_nsec/1000000.0 + (double)start->tv_sec*1000.0);
+	char path[FILE_PATH_MAX];
+	if (get_data_file_path(path, sizeof(path), location, filename) < 0)
+	{
+		return -1;
+	}
+	file_header header;
+	init_file_header(header, content, element_bits, element_count, alphabet_size, data, size);
+	if (write_data_file(path, header, data, size) < 0)
+	{
+		return -1;
+	}
+	INFO("written %s (%zu bytes, CRC32C %08x)\n", path, size, header.payload_crc);
+	return 0;
 }
 
-constexpr uint32_t THREADS_MAX = 256;
+/** Checks that a loaded file holds what the test expects.
+ *
+ * @param buffer Loaded payload, its CRC32C is verified if it is loaded whole.
+ *
+ * @return 0 on success, -1 on failure.
+ */
+static int check_input_file(
+		const struct config& conf,
+		const char*          filename,
+		const file_payload&  payload,
+		file_content         content,
+		uint32_t             element_bits,
+		const input_buffer&  buffer)
+{
+	char path[FILE_PATH_MAX];
+	if (get_data_file_path(path, sizeof(path), conf.location_of_files, filename) < 0)
+	{
+		return -1;
+	}
+	if (check_file_header(payload, path, content, element_bits) < 0)
+	{
+		return -1;
+	}
+	return buffer ? verify_payload_crc(payload, path, buffer.get<void>(), buffer.get_size()) : 0;
+}
 
-static void* thread_func(struct thread_data* thr_data)
+/** Converts table.bin to the files with all other table formats.
+ *
+ * @return 0 on success, -1 on failure.
+ */
+static int convert_table_files(const struct config& conf)
 {
-	cpu_set_t cpuset;
-	CPU_ZERO(&cpuset);
-	CPU_SET(thr_data->id, &cpuset);
-	pthread_t thread = pthread_self();
-	pthread_setaffinity_np(thread, sizeof(cpuset), &cpuset);
+	const size_t count_of_table_elements = conf.table_buffer_size / TABLE_ELEMENT_SIZE;
+	input_buffer source;
+	file_payload payload;
+	if (read_input_buffer(
+			conf.location_of_files,
+			get_table_file_name(table_format::u16),
+			conf.table_buffer_size,
+			0,
+			conf.load,
+			page_mode::normal,
+			false,
+			source,
+			payload) < 0 ||
+		check_input_file(conf, get_table_file_name(table_format::u16), payload, file_content::table, get_table_element_bits(table_format::u16), source) < 0)
+	{
+		return -1;
+	}
+	const uint32_t alphabet_size = payload.has_header ? payload.header.alphabet_size : conf.alphabet_size;
 
-	struct config*        conf = thr_data->conf;
-	const uint32_t        count_of_input_indices = thr_data->common_data->count_of_input_indices;
-	uint32_t* const       indices_arr = thr_data->common_data->indices;
-	const uint16_t* const table = thr_data->common_data->table;
-	uint16_t              value0 = TABLE_XOR_VAL;
-	uint16_t              value1 = TABLE_XOR_VAL;
-	uint16_t              value2 = TABLE_XOR_VAL;
-	uint16_t              value3 = TABLE_XOR_VAL;
-	const uint32_t        cycles = conf->cycle_count;
-	const uint32_t        table_index_mask = conf->table_index_mask;
-	struct timespec       start;
-	struct timespec       end;
-	clock_gettime(CLOCK_MONOTONIC_RAW, &start);
-	for (uint32_t cycle = 0; cycle < cycles; ++cycle)
+	for (const named_value<table_format>& format : TABLE_FORMATS)
 	{
-		for (uint32_t index = 0; index < count_of_input_indices; index += 4)
+		if (format.value == table_format::u16)
 		{
-			__m128i indices = _mm_set_epi32(
-					(indices_arr[index    ] ^ INDEX_XOR_VAL) + thr_data->id,
-					(indices_arr[index + 1] ^ INDEX_XOR_VAL) + thr_data->id,
-					(indices_arr[index + 2] ^ INDEX_XOR_VAL) + thr_data->id,
-					(indices_arr[index + 3] ^ INDEX_XOR_VAL) + thr_data->id);
-
-			value0 = (value0 ^ table[_mm_extract_epi32(indices, 0) & table_index_mask]) & TABLE_ADD_VAL;
-			value1 = (value1 ^ table[_mm_extract_epi32(indices, 1) & table_index_mask]) & TABLE_ADD_VAL;
-			value2 = (value2 ^ table[_mm_extract_epi32(indices, 2) & table_index_mask]) & TABLE_ADD_VAL;
-			value3 = (value3 ^ table[_mm_extract_epi32(indices, 3) & table_index_mask]) & TABLE_ADD_VAL;
+			continue;
+		}
 
-			indices_arr[index    ] = _mm_extract_epi32(indices, 0);
-			indices_arr[index + 1] = _mm_extract_epi32(indices, 1);
-			indices_arr[index + 2] = _mm_extract_epi32(indices, 2);
-			indices_arr[index + 3] = _mm_extract_epi32(indices, 3);
+		const size_t size = get_table_size(format.value, count_of_table_elements);
+		void* const  converted = malloc(size);
+		if (!converted)
+		{
+			ERR("malloc failed for %s table\n", format.name);
+			return -1;
+		}
+		auto free_converted = scope_exit([&]() { free(converted); });
+		convert_table(source.get<const uint16_t>(), count_of_table_elements, format.value, converted);
+		if (write_file(
+				conf.location_of_files,
+				get_table_file_name(format.value),
+				file_content::table,
+				get_table_element_bits(format.value),
+				count_of_table_elements,
+				alphabet_size,
+				converted,
+				size) < 0)
+		{
+			return -1;
 		}
 	}
-	clock_gettime(CLOCK_MONOTONIC_RAW, &end);
 
-	thr_data->table_accesses = cycles * count_of_input_indices;
-	thr_data->clock_sum = get_clockdiff_ms(&start, &end);
-	//printf("%u %u %u %u\n", value0, value1, value2, value3);
-	thr_data->value = value0 ^ value1 ^ value2 ^ value3;
+	return 0;
+}
 
-	return nullptr;
+/** Writes generated table.bin and indices.bin.
+ *
+ * @return 0 on success, -1 on failure.
+ */
+static int write_generated_files(const struct config& conf)
+{
+	input_buffer indices_buffer;
+	input_buffer table_buffer;
+	if (generate_input_buffers(
+			conf.generator,
+			conf.indices_buffer_size,
+			conf.indexing,
+			table_format::u16,
+			page_mode::normal,
+			0,
+			indices_buffer,
+			table_buffer) < 0 ||
+		write_file(
+			conf.location_of_files,
+			FILE_WITH_INDICES,
+			file_content::indices,
+			sizeof(uint32_t) * 8,
+			indices_buffer.get_size() / sizeof(uint32_t),
+			0,
+			indices_buffer.get<void>(),
+			indices_buffer.get_size()) < 0 ||
+		write_file(
+			conf.location_of_files,
+			get_table_file_name(table_format::u16),
+			file_content::table,
+			get_table_element_bits(table_format::u16),
+			conf.table_buffer_size / TABLE_ELEMENT_SIZE,
+			conf.alphabet_size,
+			table_buffer.get<void>(),
+			table_buffer.get_size()) < 0)
+	{
+		return -1;
+	}
+	INFO("other table formats are written by -C\n");
+	return 0;
+}
+
+/** Rewrites a legacy raw file as a data file with a header.
+ *
+ * Files which already have a header and missing files are skipped.
+ *
+ * @return 0 on success, -1 on failure.
+ */
+static int upgrade_file(const struct config& conf, const char* filename, file_content content, uint32_t element_bits)
+{
+	char path[FILE_PATH_MAX];
+	if (get_data_file_path(path, sizeof(path), conf.location_of_files, filename) < 0)
+	{
+		return -1;
+	}
+	if (access(path, F_OK) < 0 && errno == ENOENT)
+	{
+		return 0;
+	}
+	file_payload payload;
+	if (read_file_header(path, payload) < 0)
+	{
+		return -1;
+	}
+	if (payload.has_header)
+	{
+		INFO("%s already has a header\n", path);
+		return 0;
+	}
+
+	// Packed u12 elements come in pairs of 3 bytes.
+	const uint32_t unit_bits = element_bits == 12 ? 24 : element_bits;
+	if (payload.size % (unit_bits / 8))
+	{
+		ERR("size of %s is not a multiple of its elements\n", path);
+		return -1;
+	}
+	input_buffer buffer;
+	if (read_input_buffer(
+			conf.location_of_files,
+			filename,
+			payload.size,
+			0,
+			load_mode::read,
+			page_mode::normal,
+			false,
+			buffer,
+			payload) < 0)
+	{
+		return -1;
+	}
+
+	char      temp_path[FILE_PATH_MAX];
+	const int length = snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+	if (length < 0 || (size_t)length >= sizeof(temp_path))
+	{
+		ERR("path %s.tmp too long\n", path);
+		return -1;
+	}
+	file_header header;
+	init_file_header(
+			header,
+			content,
+			element_bits,
+			payload.size * 8 / element_bits,
+			content == file_content::table ? conf.alphabet_size : 0,
+			buffer.get<void>(),
+			buffer.get_size());
+	if (write_data_file(temp_path, header, buffer.get<void>(), buffer.get_size()) < 0)
+	{
+		unlink(temp_path);
+		return -1;
+	}
+	if (rename(temp_path, path) < 0)
+	{
+		ERR("rename(%s, %s) failed\n", temp_path, path);
+		unlink(temp_path);
+		return -1;
+	}
+	INFO("upgraded %s (CRC32C %08x)\n", path, header.payload_crc);
+	return 0;
+}
+
+/** Adds headers to the legacy raw indices.bin and table files.
+ *
+ * @return 0 on success, -1 on failure.
+ */
+static int upgrade_files(const struct config& conf)
+{
+	if (upgrade_file(conf, FILE_WITH_INDICES, file_content::indices, sizeof(uint32_t) * 8) < 0)
+	{
+		return -1;
+	}
+	for (const named_value<table_format>& format : TABLE_FORMATS)
+	{
+		if (upgrade_file(conf, get_table_file_name(format.value), file_content::table, get_table_element_bits(format.value)) < 0)
+		{
+			return -1;
+		}
+	}
+	return 0;
 }
 
 int main(int argc, char *argv[])
@@ -348,95 +2052,288 @@ int main(int argc, char *argv[])
 		return -1;
 	}
 
-	uint32_t* const indices = read_input_buffer<uint32_t>(
-			conf.location_of_files,
-			FILE_WITH_INDICES,
-			conf.indices_buffer_size);
-	if (!indices)
+	if (conf.convert_table)
+	{
+		if (convert_table_files(conf) < 0)
+		{
+			error_message = "failed to convert table";
+			return -1;
+		}
+		return 0;
+	}
+
+	if (conf.upgrade_files)
+	{
+		if (upgrade_files(conf) < 0)
+		{
+			error_message = "failed to upgrade files";
+			return -1;
+		}
+		return 0;
+	}
+
+	if (conf.write_files)
+	{
+		if (write_generated_files(conf) < 0)
+		{
+			error_message = "failed to write generated files";
+			return -1;
+		}
+		return 0;
+	}
+
+	// Parallel loads with a NUMA mode read the files straight to the memory
+	// placed on the nodes instead of copying them there.
+	const bool      load_in_place = conf.numa != numa_mode::none && conf.load != load_mode::read && is_load_to_buffer(conf.load) && !conf.generate;
+	const size_t    table_size = get_table_size(conf.format, conf.table_buffer_size / TABLE_ELEMENT_SIZE);
+	size_t          loaded_size = 0;
+	struct timespec load_start;
+	struct timespec load_end;
+	clock_gettime(CLOCK_MONOTONIC_RAW, &load_start);
+	input_buffer indices_buffer;
+	input_buffer table_buffer;
+	file_payload indices_payload;
+	file_payload table_payload;
+	index_stream stream;
+	if (conf.generate)
+	{
+		if (generate_input_buffers(
+				conf.generator,
+				conf.indices_buffer_size,
+				conf.indexing,
+				conf.format,
+				conf.table_pages,
+				TABLE_BUFFER_PADDING,
+				indices_buffer,
+				table_buffer) < 0)
+		{
+			error_message = "failed to generate buffers";
+			return -1;
+		}
+		loaded_size += conf.indices_buffer_size + table_size;
+	}
+	else if (conf.stream_chunk_size)
+	{
+		if (stream.open(conf.location_of_files, FILE_WITH_INDICES, conf.stream_chunk_size, conf.thread_count * STREAM_BUFFERS_PER_THREAD) < 0)
+		{
+			error_message = "failed to open stream of indices";
+			return -1;
+		}
+		if (check_input_file(conf, FILE_WITH_INDICES, stream.get_payload(), file_content::indices, sizeof(uint32_t) * 8, input_buffer()) < 0)
+		{
+			error_message = "unexpected contents of stream of indices";
+			return -1;
+		}
+		INFO("streamed indices: %zu bytes\n", stream.get_file_size());
+	}
+	else if (!load_in_place)
+	{
+		if (read_input_buffer(
+				conf.location_of_files,
+				FILE_WITH_INDICES,
+				conf.indices_buffer_size,
+				0,
+				conf.load,
+				page_mode::normal,
+				true,
+				indices_buffer,
+				indices_payload) < 0)
+		{
+			error_message = "failed to read buffer with indices";
+			return -1;
+		}
+		loaded_size += conf.indices_buffer_size;
+	}
+
+	if (conf.populate != populate_mode::none)
+	{
+		page_mode   obtained;
+		size_t      mapped_size;
+		void* const table = allocate_pages(table_size + TABLE_BUFFER_PADDING, conf.table_pages, obtained, mapped_size);
+		if (!table)
+		{
+			error_message = "failed to allocate buffer with table";
+			return -1;
+		}
+		table_buffer = input_buffer::from_mapping(table, table_size, mapped_size);
+
+		populate_stats stats;
+		if (populate_input_buffer(
+				conf.location_of_files,
+				conf.table_file_name,
+				conf.populate,
+				get_page_size(obtained),
+				conf.thread_count,
+				table_buffer,
+				table_payload,
+				stats) < 0)
+		{
+			error_message = "failed to populate buffer with table";
+			return -1;
+		}
+		INFO("table populate: %u threads, %.4f ms, %.3f GB/s, page faults: minor %" PRIu64 ", major %" PRIu64 "\n",
+				conf.thread_count, stats.time, stats.time > 0.0 ? table_size / (stats.time * 1e6) : 0.0,
+				stats.minor_faults, stats.major_faults);
+		loaded_size += table_size;
+	}
+	else if (!load_in_place && !conf.generate)
+	{
+		if (read_input_buffer(
+				conf.location_of_files,
+				conf.table_file_name,
+				table_size,
+				TABLE_BUFFER_PADDING,
+				conf.load,
+				conf.table_pages,
+				false,
+				table_buffer,
+				table_payload) < 0)
+		{
+			error_message = "failed to read buffer with table";
+			return -1;
+		}
+		loaded_size += table_size;
+	}
+	clock_gettime(CLOCK_MONOTONIC_RAW, &load_end);
+	double load_time = get_clockdiff_ms(&load_start, &load_end);
+	if (!conf.generate &&
+		((indices_buffer && check_input_file(conf, FILE_WITH_INDICES, indices_payload, file_content::indices, sizeof(uint32_t) * 8, indices_buffer) < 0) ||
+		(table_buffer && check_input_file(conf, conf.table_file_name, table_payload, file_content::table, get_table_element_bits(conf.format), table_buffer) < 0)))
 	{
-		error_message = "failed to read buffer with indices";
+		error_message = "unexpected contents of input files";
 		return -1;
 	}
 
-	const uint16_t* const table = read_input_buffer<uint16_t>(
-			conf.location_of_files,
-			FILE_WITH_TABLE,
-			conf.table_buffer_size);
-	if (!table)
+	numa_topology topology;
+	if (detect_numa_topology(topology) < 0)
 	{
-		error_message = "failed to read buffer with table";
-		free_input_buffer(indices);
+		error_message = "failed to detect numa topology";
 		return -1;
 	}
+	INFO("numa nodes: %u\n", topology.node_count);
 
-	const uint32_t            count_of_input_indices = conf.indices_buffer_size / sizeof(uint32_t);
-	const uint32_t            count_of_table_elements = conf.table_buffer_size / TABLE_ELEMENT_SIZE;
-	struct thread_common_data thr_common_data(indices, table, count_of_input_indices, count_of_table_elements);
-	struct thread_data        thr_data[THREADS_MAX] = {};
-	pthread_attr_t            thread_attr;
-	pthread_attr_init(&thread_attr);
-	pthread_t                 threads[THREADS_MAX] = {};
-	uint32_t                  thread_count = 0;
-	for (uint32_t thread_id = 0; thread_id < conf.thread_count; ++thread_id)
+	const uint32_t            count_of_input_indices = conf.stream_chunk_size ? 0 : conf.indices_buffer_size / sizeof(uint32_t);
+	const uint64_t            count_of_table_elements = conf.table_buffer_size / TABLE_ELEMENT_SIZE;
+	struct thread_common_data thr_common_data(count_of_input_indices, count_of_table_elements);
+	if (conf.stream_chunk_size)
 	{
-		thr_data[thread_id].conf = &conf;
-		thr_data[thread_id].common_data = &thr_common_data;
-		thr_data[thread_id].id = thread_id;
-		if (pthread_create(
-				&threads[thread_id],
-				&thread_attr,
-				(void*(*)(void*))thread_func,
-				(void*)&thr_data[thread_id]) != 0)
+		thr_common_data.stream = &stream;
+	}
+	input_buffer              node_indices[NUMA_NODES_MAX];
+	input_buffer              node_tables[NUMA_NODES_MAX];
+	for (uint32_t i = 0; i < topology.node_count; ++i)
+	{
+		const uint32_t node = topology.nodes[i];
+		if (conf.numa == numa_mode::none)
 		{
-			break;
+			thr_common_data.indices[node] = indices_buffer.get<uint32_t>();
+			thr_common_data.table[node] = table_buffer.get<const void>();
+			continue;
 		}
-		thread_count++;
+		if (conf.numa == numa_mode::interleave && i > 0)
+		{
+			// Interleaved copy is created only once and shared by all nodes.
+			thr_common_data.indices[node] = thr_common_data.indices[topology.nodes[0]];
+			thr_common_data.table[node] = thr_common_data.table[topology.nodes[0]];
+			continue;
+		}
+
+		if (load_in_place)
+		{
+			const bool load_indices = !conf.stream_chunk_size;
+			clock_gettime(CLOCK_MONOTONIC_RAW, &load_start);
+			if ((load_indices &&
+					(allocate_numa_buffer(conf.indices_buffer_size, 0, page_mode::normal, conf.numa, node, topology, node_indices[node]) < 0 ||
+					fill_input_buffer(conf.location_of_files, FILE_WITH_INDICES, conf.load, node_indices[node], indices_payload) < 0)) ||
+				allocate_numa_buffer(table_size, TABLE_BUFFER_PADDING, conf.table_pages, conf.numa, node, topology, node_tables[node]) < 0 ||
+				fill_input_buffer(conf.location_of_files, conf.table_file_name, conf.load, node_tables[node], table_payload) < 0)
+			{
+				error_message = "failed to load buffers on numa nodes";
+				return -1;
+			}
+			clock_gettime(CLOCK_MONOTONIC_RAW, &load_end);
+			load_time += get_clockdiff_ms(&load_start, &load_end);
+			if ((load_indices && check_input_file(conf, FILE_WITH_INDICES, indices_payload, file_content::indices, sizeof(uint32_t) * 8, node_indices[node]) < 0) ||
+				check_input_file(conf, conf.table_file_name, table_payload, file_content::table, get_table_element_bits(conf.format), node_tables[node]) < 0)
+			{
+				error_message = "unexpected contents of input files";
+				return -1;
+			}
+			loaded_size += (load_indices ? conf.indices_buffer_size : 0) + table_size;
+		}
+		else if ((indices_buffer && create_numa_copy(indices_buffer, 0, page_mode::normal, conf.numa, node, topology, node_indices[node]) < 0) ||
+			create_numa_copy(table_buffer, TABLE_BUFFER_PADDING, conf.table_pages, conf.numa, node, topology, node_tables[node]) < 0)
+		{
+			error_message = "failed to place buffers on numa nodes";
+			return -1;
+		}
+		thr_common_data.indices[node] = node_indices[node].get<uint32_t>();
+		thr_common_data.table[node] = node_tables[node].get<const void>();
+		INFO("node %u: table on node %d, indices on node %d\n",
+				node,
+				get_memory_node(thr_common_data.table[node]),
+				get_memory_node(thr_common_data.indices[node]));
+	}
+	INFO("%s time: %.4f ms, %zu bytes, %.3f GB/s\n",
+			conf.generate ? "generate" : "load", load_time, loaded_size, load_time > 0.0 ? loaded_size / (load_time * 1e6) : 0.0);
+	if (conf.numa != numa_mode::none)
+	{
+		// Only the copies are used.
+		indices_buffer.reset();
+		table_buffer.reset();
 	}
 
-	for (uint32_t thread_id = 0; thread_id < thread_count; ++thread_id)
+	size_t kernel_page_size = 0;
+	size_t anon_huge_size = 0;
+	if (query_page_backing(thr_common_data.table[topology.nodes[0]], kernel_page_size, anon_huge_size) == 0)
 	{
-		pthread_join(threads[thread_id], nullptr);
+		INFO("table pages: page size %zu kB, transparent huge pages %zu kB of %zu kB\n",
+				kernel_page_size / 1024, anon_huge_size / 1024, get_table_size(conf.format, count_of_table_elements) / 1024);
 	}
 
-	if (thread_count < conf.thread_count)
+	if ((conf.kernel->flags & KERNEL_FLAG_PREFETCH) && conf.prefetch_distance == PREFETCH_DISTANCE_AUTO)
 	{
-		// Not all threads were created, so the test is irrelevant.
-		error_message = "test failed";
-		free_input_buffer(table);
-		free_input_buffer(indices);
+		conf.prefetch_distance = tune_prefetch_distance(
+				conf,
+				thr_common_data.indices[topology.nodes[0]],
+				count_of_input_indices,
+				thr_common_data.table[topology.nodes[0]]);
+	}
+
+	if (conf.indices == indices_mode::slice && !conf.stream_chunk_size && count_of_input_indices < conf.thread_count)
+	{
+		error_message = "less indices than threads";
 		return -1;
 	}
 
-	uint64_t table_accesses = 0;
 	uint16_t value = 0;
-	double clock_sum = 0.0;
-	double clock_sum_max = 0.0;
-	double throughput_sum = 0.0;
-	for (uint32_t thread_id = 0; thread_id < thread_count; ++thread_id)
+	uint32_t run_index = 0;
+	if ((conf.kernel->flags & KERNEL_FLAG_STREAMS) && conf.stream_count == STREAM_COUNT_ALL)
+	{
+		for (const uint32_t stream_count : KERNEL_STREAM_COUNTS)
+		{
+			INFO("streams: %u\n", stream_count);
+			conf.stream_count = stream_count;
+			uint16_t stream_value = 0;
+			if (run_threads(conf, thr_common_data, topology, run_index++, stream_value) < 0)
+			{
+				error_message = "test failed";
+				return -1;
+			}
+			value ^= stream_value;
+		}
+	}
+	else if (run_threads(conf, thr_common_data, topology, run_index, value) < 0)
 	{
-		table_accesses += thr_data[thread_id].table_accesses;
-		clock_sum += thr_data[thread_id].clock_sum;
-		clock_sum_max = std::max(clock_sum_max, thr_data[thread_id].clock_sum);
-		value += thr_data[thread_id].value;
-		throughput_sum += ((thr_data[thread_id].table_accesses / 1000.0) / thr_data[thread_id].clock_sum);
+		error_message = "test failed";
+		return -1;
 	}
-	uint64_t table_accesses_avg = table_accesses / thread_count;
-	double clock_sum_avg = clock_sum / (double)thread_count;
-
-	INFO("table accesses: %zu\n", table_accesses);
-	INFO("clockdiff: %.4f ms\n", clock_sum);
-	const double data_read_written = table_accesses * sizeof(uint16_t);
-	INFO("data_read_written: %.4f\n", data_read_written);
-	INFO("throughput: %.4f MB/s\n", (data_read_written / 1000.0) / clock_sum);
-	INFO("transactions: AVG per thread %.4f MT/s (a=%zu dt=%.4f), AVG all threads %.4f MT/s (a=%zu dt=%.4f), %.4f MT/s (a=%zu dt=%.4f) THR sum %.4f MT/s\n",
-			(table_accesses_avg / 1000.0) / clock_sum_avg, table_accesses_avg, clock_sum_avg,
-			(table_accesses / 1000.0) / clock_sum, table_accesses, clock_sum,
-			(table_accesses / 1000.0) / clock_sum_max, table_accesses, clock_sum_max,
-			throughput_sum);
-	INFO("value: %u\n", value);
 
-	free_input_buffer(table);
-	free_input_buffer(indices);
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) == 0)
+	{
+		INFO("max RSS: %ld kB\n", usage.ru_maxrss);
+	}
 
 	return value;
 }
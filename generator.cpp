@@ -0,0 +1,405 @@
+#include "generator.h"
+#include "common.h"
+#include "cpu_features.h"
+#include "named_value.h"
+
+#include <emmintrin.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <utility>
+
+constexpr uint32_t GENERATOR_THREADS_MAX = 256;
+constexpr uint32_t GENERATOR_PARAMS_MAX  = 2;
+// Streams of the PRNG of the table and of the indices, so they are not correlated.
+constexpr uint64_t TABLE_STREAM          = 0x7461626c65ull;
+constexpr uint64_t INDICES_STREAM        = 0x696e646963ull;
+// Odd multiplier scattering zipf ranks over the table, a bijection for power of two tables.
+constexpr uint64_t ZIPF_SCATTER          = 0x9E3779B1ull;
+
+constexpr named_value<index_distribution> INDEX_DISTRIBUTIONS[] =
+{
+	{ "uniform",    index_distribution::uniform    },
+	{ "zipf",       index_distribution::zipf       },
+	{ "sequential", index_distribution::sequential },
+	{ "strided",    index_distribution::strided    },
+	{ "clustered",  index_distribution::clustered  },
+};
+
+int parse_generator_spec(const char* spec, generator_config& generator)
+{
+	char buf[256];
+	if (strlen(spec) >= sizeof(buf))
+	{
+		return -1;
+	}
+	strcpy(buf, spec);
+
+	const char* params[GENERATOR_PARAMS_MAX] = {};
+	uint32_t    param_count = 0;
+	char*       separator = strchr(buf, ':');
+	while (separator)
+	{
+		*separator = '\0';
+		if (param_count == GENERATOR_PARAMS_MAX)
+		{
+			return -1;
+		}
+		params[param_count++] = separator + 1;
+		separator = strchr(separator + 1, ':');
+	}
+	if (parse_named_value(INDEX_DISTRIBUTIONS, buf, generator.distribution) < 0)
+	{
+		return -1;
+	}
+
+	switch (generator.distribution)
+	{
+		case index_distribution::uniform:
+		case index_distribution::sequential:
+			return param_count == 0 ? 0 : -1;
+
+		case index_distribution::zipf:
+			if (param_count > 1)
+			{
+				return -1;
+			}
+			if (param_count)
+			{
+				generator.skew = strtod(params[0], nullptr);
+			}
+			return generator.skew > 0.0 ? 0 : -1;
+
+		case index_distribution::strided:
+			if (param_count > 1)
+			{
+				return -1;
+			}
+			if (param_count)
+			{
+				generator.stride = (uint32_t)strtoul(params[0], nullptr, 10);
+			}
+			return generator.stride ? 0 : -1;
+
+		case index_distribution::clustered:
+			if (param_count > 0)
+			{
+				generator.cluster_size = (uint32_t)strtoul(params[0], nullptr, 10);
+			}
+			if (param_count > 1)
+			{
+				generator.cluster_length = (uint32_t)strtoul(params[1], nullptr, 10);
+			}
+			return generator.cluster_size && generator.cluster_length ? 0 : -1;
+	}
+	return -1;
+}
+
+void format_generator_spec(const generator_config& generator, char* buf, size_t size)
+{
+	const char* const name = get_value_name(INDEX_DISTRIBUTIONS, generator.distribution);
+	switch (generator.distribution)
+	{
+		case index_distribution::zipf:
+			snprintf(buf, size, "%s:%g", name, generator.skew);
+			break;
+
+		case index_distribution::strided:
+			snprintf(buf, size, "%s:%u", name, generator.stride);
+			break;
+
+		case index_distribution::clustered:
+			snprintf(buf, size, "%s:%u:%u", name, generator.cluster_size, generator.cluster_length);
+			break;
+
+		default:
+			snprintf(buf, size, "%s", name);
+			break;
+	}
+}
+
+void print_index_distributions(FILE* file)
+{
+	print_value_names(file, INDEX_DISTRIBUTIONS);
+}
+
+static inline __m128i rotl_sse2(__m128i value, int bits)
+{
+	return _mm_or_si128(_mm_slli_epi32(value, bits), _mm_srli_epi32(value, 32 - bits));
+}
+
+void prng_fill_sse2(uint32_t* state, uint32_t* values, size_t count)
+{
+	// Lanes 0-3 and 4-7 are two independent halves.
+	for (uint32_t half = 0; half < PRNG_LANES; half += 4)
+	{
+		__m128i s0 = _mm_loadu_si128((const __m128i*)(state + 0 * PRNG_LANES + half));
+		__m128i s1 = _mm_loadu_si128((const __m128i*)(state + 1 * PRNG_LANES + half));
+		__m128i s2 = _mm_loadu_si128((const __m128i*)(state + 2 * PRNG_LANES + half));
+		__m128i s3 = _mm_loadu_si128((const __m128i*)(state + 3 * PRNG_LANES + half));
+		for (size_t i = half; i < count; i += PRNG_LANES)
+		{
+			const __m128i result = _mm_add_epi32(rotl_sse2(_mm_add_epi32(s0, s3), 7), s0);
+			const __m128i t = _mm_slli_epi32(s1, 9);
+			s2 = _mm_xor_si128(s2, s0);
+			s3 = _mm_xor_si128(s3, s1);
+			s1 = _mm_xor_si128(s1, s2);
+			s0 = _mm_xor_si128(s0, s3);
+			s2 = _mm_xor_si128(s2, t);
+			s3 = rotl_sse2(s3, 11);
+			_mm_storeu_si128((__m128i*)(values + i), result);
+		}
+		_mm_storeu_si128((__m128i*)(state + 0 * PRNG_LANES + half), s0);
+		_mm_storeu_si128((__m128i*)(state + 1 * PRNG_LANES + half), s1);
+		_mm_storeu_si128((__m128i*)(state + 2 * PRNG_LANES + half), s2);
+		_mm_storeu_si128((__m128i*)(state + 3 * PRNG_LANES + half), s3);
+	}
+}
+
+/// Finalizer of splitmix64, hashes @p value to well mixed bits.
+static uint64_t mix64(uint64_t value)
+{
+	value += 0x9E3779B97F4A7C15ull;
+	value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+	value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+	return value ^ (value >> 31);
+}
+
+/// Work shared by the generating threads.
+struct generate_job
+{
+	/// Output, u32 words of the table or the indices.
+	uint32_t*               values;
+
+	size_t                  count;
+
+	uint64_t                stream;
+
+	/// Distribution of the indices, nullptr for the table.
+	const generator_config* generator;
+
+	uint64_t                seed;
+
+	/// Count of the slots of the table, see get_table_slot_count().
+	size_t                  count_of_table_elements;
+
+	/// Reduction the generated slots are stored for, nullptr for the table.
+	const table_indexing*   indexing;
+
+	/// Precomputed terms of the inverse of the zipf distribution.
+	double                  zipf_exponent;
+
+	double                  zipf_range;
+
+	void                    (*prng_fill)(uint32_t* state, uint32_t* values, size_t count);
+
+	std::atomic<size_t>     next_block{0};
+};
+
+/// Maps a uniform random word to an element of the zipf distribution.
+static uint32_t get_zipf_element(const generate_job& job, uint32_t random)
+{
+	// Inverse of the distribution of a continuous power law over [1, n + 1),
+	// ranks are its integer parts.
+	const double uniform = (random + 0.5) / 4294967296.0;
+	const double x = job.zipf_exponent == 0.0 ?
+			exp(uniform * job.zipf_range) :
+			pow(1.0 + uniform * job.zipf_range, 1.0 / job.zipf_exponent);
+	const uint64_t rank = std::min<uint64_t>((uint64_t)x - 1, job.count_of_table_elements - 1);
+	return (uint32_t)(rank * ZIPF_SCATTER % job.count_of_table_elements);
+}
+
+static uint32_t get_element(const generate_job& job, uint64_t position, uint32_t random)
+{
+	const generator_config& generator = *job.generator;
+	const uint64_t          count = job.count_of_table_elements;
+	switch (generator.distribution)
+	{
+		case index_distribution::uniform:
+			return (uint32_t)(((uint64_t)random * count) >> 32);
+
+		case index_distribution::zipf:
+			return get_zipf_element(job, random);
+
+		case index_distribution::sequential:
+			return (uint32_t)(position % count);
+
+		case index_distribution::strided:
+			return (uint32_t)(position * generator.stride % count);
+
+		case index_distribution::clustered:
+		{
+			// Window of each run depends only on the seed and the run, so runs may
+			// span blocks.
+			const uint64_t run = position / generator.cluster_length;
+			const uint64_t base = mix64(job.seed ^ mix64(run)) % count;
+			return (uint32_t)((base + (((uint64_t)random * generator.cluster_size) >> 32)) % count);
+		}
+	}
+	return 0;
+}
+
+static void generate_block(generate_job& job, size_t block)
+{
+	uint32_t  state[4 * PRNG_LANES];
+	uint64_t  seed = mix64(job.seed ^ mix64(job.stream ^ mix64(block)));
+	for (uint32_t word = 0; word < 4 * PRNG_LANES; word += 2)
+	{
+		seed = mix64(seed);
+		state[word] = (uint32_t)seed;
+		state[word + 1] = (uint32_t)(seed >> 32);
+	}
+
+	const size_t    first = block * GENERATOR_BLOCK_SIZE;
+	const size_t    count = std::min(GENERATOR_BLOCK_SIZE, job.count - first);
+	const size_t    vector_count = count / PRNG_LANES * PRNG_LANES;
+	uint32_t* const values = job.values + first;
+	job.prng_fill(state, values, vector_count);
+	if (vector_count < count)
+	{
+		uint32_t tail[PRNG_LANES];
+		job.prng_fill(state, tail, PRNG_LANES);
+		memcpy(values + vector_count, tail, (count - vector_count) * sizeof(uint32_t));
+	}
+
+	if (job.generator)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			values[i] = get_slot_index(*job.indexing, get_element(job, first + i, values[i])) ^ INDEX_XOR_VAL;
+		}
+	}
+}
+
+static void* generate_thread_func(void* arg)
+{
+	generate_job& job = *(generate_job*)arg;
+	const size_t  block_count = (job.count + GENERATOR_BLOCK_SIZE - 1) / GENERATOR_BLOCK_SIZE;
+	for (size_t block = job.next_block.fetch_add(1); block < block_count; block = job.next_block.fetch_add(1))
+	{
+		generate_block(job, block);
+	}
+	return nullptr;
+}
+
+static void run_job(generate_job& job, uint32_t thread_count)
+{
+	job.prng_fill = (detect_cpu_features() & CPU_FEATURE_AVX2) ? prng_fill_avx2 : prng_fill_sse2;
+
+	// The calling thread generates too, threads which cannot be created just
+	// leave more blocks to the others.
+	const size_t block_count = (job.count + GENERATOR_BLOCK_SIZE - 1) / GENERATOR_BLOCK_SIZE;
+	thread_count = (uint32_t)std::min<size_t>(std::min(thread_count, GENERATOR_THREADS_MAX), block_count);
+	pthread_t threads[GENERATOR_THREADS_MAX];
+	uint32_t  started = 0;
+	for (uint32_t i = 1; i < thread_count; ++i)
+	{
+		if (pthread_create(&threads[started], nullptr, generate_thread_func, &job) != 0)
+		{
+			break;
+		}
+		started++;
+	}
+	generate_thread_func(&job);
+	for (uint32_t i = 0; i < started; ++i)
+	{
+		pthread_join(threads[i], nullptr);
+	}
+}
+
+void generate_table(uint16_t* table, size_t count_of_elements, uint64_t seed, uint32_t thread_count)
+{
+	generate_job job;
+	job.values = (uint32_t*)table;
+	job.count = count_of_elements / 2;
+	job.stream = TABLE_STREAM;
+	job.generator = nullptr;
+	job.seed = seed;
+	job.count_of_table_elements = count_of_elements;
+	job.indexing = nullptr;
+	job.zipf_exponent = 0.0;
+	job.zipf_range = 0.0;
+	run_job(job, thread_count);
+}
+
+void generate_indices(
+		uint32_t*               indices,
+		size_t                  count_of_indices,
+		const table_indexing&   indexing,
+		const generator_config& generator,
+		uint32_t                thread_count)
+{
+	generate_job job;
+	job.values = indices;
+	job.count = count_of_indices;
+	job.stream = INDICES_STREAM;
+	job.generator = &generator;
+	job.seed = generator.seed;
+	job.count_of_table_elements = get_table_slot_count(indexing);
+	job.indexing = &indexing;
+	// Skew 1 is the limit of the general formula, it needs the logarithm.
+	job.zipf_exponent = fabs(1.0 - generator.skew) < 1e-9 ? 0.0 : 1.0 - generator.skew;
+	job.zipf_range = job.zipf_exponent == 0.0 ?
+			log((double)job.count_of_table_elements + 1.0) :
+			pow((double)job.count_of_table_elements + 1.0, job.zipf_exponent) - 1.0;
+	run_job(job, thread_count);
+}
+
+int generate_input_buffers(
+		const generator_config& generator,
+		size_t                  indices_size,
+		const table_indexing&   indexing,
+		table_format            format,
+		page_mode               table_pages,
+		size_t                  table_padding,
+		input_buffer&           indices,
+		input_buffer&           table)
+{
+	const long     cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+	const uint32_t thread_count = cpu_count > 0 ? (uint32_t)cpu_count : 1;
+	const size_t   count_of_table_elements = indexing.count;
+
+	page_mode   obtained;
+	size_t      mapped_size;
+	void* const indices_data = allocate_pages(indices_size, page_mode::normal, obtained, mapped_size);
+	if (!indices_data)
+	{
+		ERR("allocation of generated indices failed\n");
+		return -1;
+	}
+	input_buffer generated_indices = input_buffer::from_mapping(indices_data, indices_size, mapped_size);
+	generate_indices((uint32_t*)indices_data, indices_size / sizeof(uint32_t), indexing, generator, thread_count);
+
+	const size_t table_size = get_table_size(format, count_of_table_elements);
+	void* const  table_data = allocate_pages(table_size + table_padding, table_pages, obtained, mapped_size);
+	if (!table_data)
+	{
+		ERR("allocation of generated table failed\n");
+		return -1;
+	}
+	input_buffer generated_table = input_buffer::from_mapping(table_data, table_size, mapped_size);
+	if (format == table_format::u16)
+	{
+		generate_table((uint16_t*)table_data, count_of_table_elements, generator.seed, thread_count);
+	}
+	else
+	{
+		uint16_t* const source = (uint16_t*)malloc(count_of_table_elements * sizeof(uint16_t));
+		if (!source)
+		{
+			ERR("malloc failed for generated table\n");
+			return -1;
+		}
+		generate_table(source, count_of_table_elements, generator.seed, thread_count);
+		convert_table(source, count_of_table_elements, format, table_data);
+		free(source);
+	}
+
+	indices = std::move(generated_indices);
+	table = std::move(generated_table);
+	return 0;
+}
@@ -0,0 +1,144 @@
+#ifndef _GENERATOR_H_
+#define _GENERATOR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "input_buffer.h"
+#include "memory.h"
+#include "table_format.h"
+#include "table_index.h"
+
+/// Distribution of the table elements looked up by generated indices.
+enum class index_distribution : uint32_t
+{
+	/// All elements equally likely.
+	uniform,
+	/// Zipfian ranks scattered over the table, a small hot set gets most lookups.
+	zipf,
+	/// Elements in order, wrapping at the end of the table.
+	sequential,
+	/// Every stride-th element, wrapping at the end of the table.
+	strided,
+	/// Runs of uniform lookups within a window at a random place of the table.
+	clustered,
+};
+
+constexpr double   ZIPF_SKEW_DEFAULT      = 0.99;
+constexpr uint32_t STRIDE_DEFAULT         = 16;
+constexpr uint32_t CLUSTER_SIZE_DEFAULT   = 4096;
+constexpr uint32_t CLUSTER_LENGTH_DEFAULT = 64;
+constexpr uint64_t GENERATOR_SEED_DEFAULT = 1;
+/// Count of values generated from one seed, the unit of work of the generating threads.
+constexpr size_t   GENERATOR_BLOCK_SIZE   = 64 * 1024;
+/// Count of independent streams of the PRNG, one per SIMD lane.
+constexpr uint32_t PRNG_LANES             = 8;
+
+struct generator_config
+{
+	index_distribution distribution = index_distribution::uniform;
+
+	/// Exponent of the zipf distribution, higher values shrink the hot set.
+	double             skew = ZIPF_SKEW_DEFAULT;
+
+	/// Distance of consecutive strided indices in elements.
+	uint32_t           stride = STRIDE_DEFAULT;
+
+	/// Count of elements of the window of clustered indices.
+	uint32_t           cluster_size = CLUSTER_SIZE_DEFAULT;
+
+	/// Count of consecutive clustered indices within one window.
+	uint32_t           cluster_length = CLUSTER_LENGTH_DEFAULT;
+
+	uint64_t           seed = GENERATOR_SEED_DEFAULT;
+};
+
+/** Parses a distribution with optional parameters.
+ *
+ * The specification looks like "uniform", "zipf[:<skew>]", "sequential",
+ * "strided[:<stride>]" or "clustered[:<cluster_size>[:<cluster_length>]]",
+ * parameters not given keep their values in @p generator.
+ *
+ * @return 0 on success, -1 on invalid specification.
+ */
+int parse_generator_spec(const char* spec, generator_config& generator);
+
+/// Formats the distribution with its parameters as accepted by parse_generator_spec().
+void format_generator_spec(const generator_config& generator, char* buf, size_t size);
+
+/// Prints names of the distributions separated by spaces.
+void print_index_distributions(FILE* file);
+
+/** Fills a table with pseudo-random elements.
+ *
+ * The contents depend only on @p seed, not on @p thread_count.
+ *
+ * @param table             Table with u16 elements.
+ * @param count_of_elements Count of elements, even.
+ * @param seed              Seed of the PRNG.
+ * @param thread_count      Count of generating threads.
+ */
+void generate_table(uint16_t* table, size_t count_of_elements, uint64_t seed, uint32_t thread_count);
+
+/** Fills a buffer with indices looking up table elements of the distribution.
+ *
+ * The elements are drawn from the slots of the table (see get_slot_index())
+ * and stored as indices reduced to them, XORed with INDEX_XOR_VAL, so the
+ * first pass of the kernels looks up exactly the generated elements. The
+ * contents depend only on @p generator, the count and @p indexing, not on
+ * @p thread_count.
+ *
+ * @param indices          Output buffer.
+ * @param count_of_indices Count of indices to generate.
+ * @param indexing         Reduction of the indices to the table they look up.
+ * @param generator        Distribution and seed.
+ * @param thread_count     Count of generating threads.
+ */
+void generate_indices(
+		uint32_t*               indices,
+		size_t                  count_of_indices,
+		const table_indexing&   indexing,
+		const generator_config& generator,
+		uint32_t                thread_count);
+
+/** Allocates buffers and generates the indices and the table in them.
+ *
+ * Stands in for loading indices.bin and the table file of @p format, tables
+ * of other formats than u16 are converted from the generated u16 table like
+ * the files written by convert_table(). Uses a thread per online CPU.
+ *
+ * @param generator     Distribution of the indices and seed.
+ * @param indices_size  Size of the indices in bytes.
+ * @param indexing      Reduction of the indices to the table, its count of elements.
+ * @param format        Format of the table.
+ * @param table_pages   Size of pages backing the table.
+ * @param table_padding Count of zeroed bytes after the end of the table.
+ * @param indices       Output buffer with the indices.
+ * @param table         Output buffer with the table.
+ *
+ * @return 0 on success, -1 on failure.
+ */
+int generate_input_buffers(
+		const generator_config& generator,
+		size_t                  indices_size,
+		const table_indexing&   indexing,
+		table_format            format,
+		page_mode               table_pages,
+		size_t                  table_padding,
+		input_buffer&           indices,
+		input_buffer&           table);
+
+/** Fills @p values with the output of PRNG_LANES interleaved xoshiro128++ streams.
+ *
+ * Value i comes from lane i % PRNG_LANES, so all implementations produce the
+ * same sequence for the same state.
+ *
+ * @param state  State of the lanes, 4 words per lane stored as state[word * PRNG_LANES + lane].
+ * @param values Output buffer.
+ * @param count  Count of values, a multiple of PRNG_LANES.
+ */
+void prng_fill_sse2(uint32_t* state, uint32_t* values, size_t count);
+void prng_fill_avx2(uint32_t* state, uint32_t* values, size_t count);
+
+#endif /* end of include guard: _GENERATOR_H_ */
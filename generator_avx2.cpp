@@ -0,0 +1,32 @@
+#include "generator.h"
+
+#include <immintrin.h>
+
+static inline __m256i rotl_avx2(__m256i value, int bits)
+{
+	return _mm256_or_si256(_mm256_slli_epi32(value, bits), _mm256_srli_epi32(value, 32 - bits));
+}
+
+void prng_fill_avx2(uint32_t* state, uint32_t* values, size_t count)
+{
+	__m256i s0 = _mm256_loadu_si256((const __m256i*)(state + 0 * PRNG_LANES));
+	__m256i s1 = _mm256_loadu_si256((const __m256i*)(state + 1 * PRNG_LANES));
+	__m256i s2 = _mm256_loadu_si256((const __m256i*)(state + 2 * PRNG_LANES));
+	__m256i s3 = _mm256_loadu_si256((const __m256i*)(state + 3 * PRNG_LANES));
+	for (size_t i = 0; i < count; i += PRNG_LANES)
+	{
+		const __m256i result = _mm256_add_epi32(rotl_avx2(_mm256_add_epi32(s0, s3), 7), s0);
+		const __m256i t = _mm256_slli_epi32(s1, 9);
+		s2 = _mm256_xor_si256(s2, s0);
+		s3 = _mm256_xor_si256(s3, s1);
+		s1 = _mm256_xor_si256(s1, s2);
+		s0 = _mm256_xor_si256(s0, s3);
+		s2 = _mm256_xor_si256(s2, t);
+		s3 = rotl_avx2(s3, 11);
+		_mm256_storeu_si256((__m256i*)(values + i), result);
+	}
+	_mm256_storeu_si256((__m256i*)(state + 0 * PRNG_LANES), s0);
+	_mm256_storeu_si256((__m256i*)(state + 1 * PRNG_LANES), s1);
+	_mm256_storeu_si256((__m256i*)(state + 2 * PRNG_LANES), s2);
+	_mm256_storeu_si256((__m256i*)(state + 3 * PRNG_LANES), s3);
+}
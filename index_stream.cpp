@@ -0,0 +1,216 @@
+#include "index_stream.h"
+#include "common.h"
+#include "crc32c.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+
+index_stream::~index_stream()
+{
+	stop();
+	if (fd >= 0)
+	{
+		close(fd);
+	}
+}
+
+int index_stream::open(const char* const location, const char* const filename, const size_t chunk_size_rhs, const uint32_t buffer_count_rhs)
+{
+	if (!chunk_size_rhs || chunk_size_rhs % sizeof(uint32_t) || !buffer_count_rhs || buffer_count_rhs > INDEX_STREAM_BUFFERS_MAX)
+	{
+		ERR("invalid chunk size %zu or buffer count %u\n", chunk_size_rhs, buffer_count_rhs);
+		return -1;
+	}
+
+	char path[FILE_PATH_MAX];
+	if (get_data_file_path(path, sizeof(path), location, filename) < 0)
+	{
+		return -1;
+	}
+	fd = ::open(path, O_RDONLY);
+	if (fd < 0)
+	{
+		ERR("open(%s) failed\n", path);
+		return -1;
+	}
+	if (read_file_header(fd, path, payload) < 0)
+	{
+		return -1;
+	}
+	file_size = payload.size;
+	posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+	const size_t size = chunk_size_rhs * buffer_count_rhs;
+	page_mode    obtained;
+	size_t       mapped_size;
+	void* const  buffers = allocate_pages(size, page_mode::normal, obtained, mapped_size);
+	if (!buffers)
+	{
+		ERR("allocation of %u buffers of %zu bytes failed\n", buffer_count_rhs, chunk_size_rhs);
+		return -1;
+	}
+	memory = input_buffer::from_mapping(buffers, size, mapped_size);
+	chunk_size = chunk_size_rhs;
+	buffer_count = buffer_count_rhs;
+	return 0;
+}
+
+int index_stream::start()
+{
+	stop();
+	if (lseek(fd, payload.offset, SEEK_SET) < 0)
+	{
+		return -1;
+	}
+
+	filled_first = 0;
+	filled_count = 0;
+	for (uint32_t buffer = 0; buffer < buffer_count; ++buffer)
+	{
+		free_buffers[buffer] = buffer_count - 1 - buffer;
+	}
+	free_count = buffer_count;
+	finished = false;
+	stopping = false;
+	failed = false;
+	bytes_read = 0;
+	read_time = 0.0;
+	crc = 0;
+
+	if (pthread_create(&reader, nullptr, (void*(*)(void*))reader_func, (void*)this) != 0)
+	{
+		return -1;
+	}
+	reader_running = true;
+	return 0;
+}
+
+void* index_stream::reader_func(index_stream* const stream)
+{
+	stream->read_chunks();
+	return nullptr;
+}
+
+void index_stream::read_chunks()
+{
+	for (;;)
+	{
+		pthread_mutex_lock(&mutex);
+		while (!free_count && !stopping)
+		{
+			pthread_cond_wait(&free_cond, &mutex);
+		}
+		if (stopping)
+		{
+			pthread_mutex_unlock(&mutex);
+			return;
+		}
+		const uint32_t buffer = free_buffers[--free_count];
+		pthread_mutex_unlock(&mutex);
+
+		// Reads whole chunks, a short read only ends the payload.
+		char* const     data = memory.get<char>() + buffer * chunk_size;
+		const size_t    wanted = (size_t)std::min<uint64_t>(chunk_size, file_size - bytes_read);
+		size_t          size = 0;
+		bool            error = false;
+		struct timespec start;
+		struct timespec end;
+		clock_gettime(CLOCK_MONOTONIC_RAW, &start);
+		while (size < wanted)
+		{
+			const ssize_t count = read(fd, data + size, wanted - size);
+			if (count < 0 && errno == EINTR)
+			{
+				continue;
+			}
+			if (count <= 0)
+			{
+				error = count < 0;
+				break;
+			}
+			size += count;
+		}
+		clock_gettime(CLOCK_MONOTONIC_RAW, &end);
+		if (payload.has_header)
+		{
+			crc = crc32c(crc, data, size);
+			if (size < chunk_size && !error && (bytes_read + size != file_size || crc != payload.header.payload_crc))
+			{
+				ERR("payload of indices file is corrupted or truncated\n");
+				error = true;
+			}
+		}
+
+		pthread_mutex_lock(&mutex);
+		read_time += ((double)end.tv_nsec / 1000000.0 + (double)end.tv_sec * 1000.0) -
+				((double)start.tv_nsec / 1000000.0 + (double)start.tv_sec * 1000.0);
+		bytes_read += size;
+		const uint32_t count = (uint32_t)(size / sizeof(uint32_t));
+		if (count)
+		{
+			const uint32_t slot = (filled_first + filled_count) % INDEX_STREAM_BUFFERS_MAX;
+			filled[slot] = buffer;
+			counts[slot] = count;
+			filled_count++;
+		}
+		else
+		{
+			free_buffers[free_count++] = buffer;
+		}
+		failed |= error;
+		finished = size < chunk_size;
+		pthread_cond_broadcast(&filled_cond);
+		pthread_mutex_unlock(&mutex);
+		if (finished)
+		{
+			return;
+		}
+	}
+}
+
+bool index_stream::acquire(index_chunk& chunk)
+{
+	pthread_mutex_lock(&mutex);
+	while (!filled_count && !finished && !stopping)
+	{
+		pthread_cond_wait(&filled_cond, &mutex);
+	}
+	const bool acquired = filled_count && !failed;
+	if (acquired)
+	{
+		chunk.buffer = filled[filled_first];
+		chunk.count = counts[filled_first];
+		chunk.indices = (uint32_t*)(memory.get<char>() + chunk.buffer * chunk_size);
+		filled_first = (filled_first + 1) % INDEX_STREAM_BUFFERS_MAX;
+		filled_count--;
+	}
+	pthread_mutex_unlock(&mutex);
+	return acquired;
+}
+
+void index_stream::release(const index_chunk& chunk)
+{
+	pthread_mutex_lock(&mutex);
+	free_buffers[free_count++] = chunk.buffer;
+	pthread_cond_signal(&free_cond);
+	pthread_mutex_unlock(&mutex);
+}
+
+void index_stream::stop()
+{
+	if (!reader_running)
+	{
+		return;
+	}
+	pthread_mutex_lock(&mutex);
+	stopping = true;
+	pthread_cond_broadcast(&free_cond);
+	pthread_cond_broadcast(&filled_cond);
+	pthread_mutex_unlock(&mutex);
+	pthread_join(reader, nullptr);
+	reader_running = false;
+}
@@ -0,0 +1,158 @@
+#ifndef _INDEX_STREAM_H_
+#define _INDEX_STREAM_H_
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "input_buffer.h"
+
+/// Maximal count of buffers of index_stream.
+constexpr uint32_t INDEX_STREAM_BUFFERS_MAX = 512;
+
+/// Part of the indices file in one of the buffers of index_stream.
+struct index_chunk
+{
+	uint32_t* indices;
+
+	uint32_t  count;
+
+	/// Buffer holding the chunk, returned by index_stream::release().
+	uint32_t  buffer;
+};
+
+/** Reader of a file with indices of any size in chunks.
+ *
+ * A reader thread reads the file sequentially to a ring of buffers, the
+ * consumers take the filled buffers in file order and return them when they
+ * are done with them. With two buffers per consumer the next chunk of each
+ * consumer is read while it processes the current one.
+ */
+class index_stream
+{
+public:
+	index_stream() = default;
+
+	~index_stream();
+
+	/** Opens the file and allocates the buffers.
+	 *
+	 * Only the payload of the file is streamed, its CRC32C is verified at the
+	 * end of each pass if the file has a header.
+	 *
+	 * @param chunk_size   Size of a chunk in bytes, a multiple of sizeof(uint32_t).
+	 * @param buffer_count Count of buffers, at most INDEX_STREAM_BUFFERS_MAX.
+	 *
+	 * @return 0 on success, -1 on failure.
+	 */
+	int open(const char* location, const char* filename, size_t chunk_size, uint32_t buffer_count);
+
+	/** Starts the reader thread at the beginning of the file.
+	 *
+	 * @return 0 on success, -1 on failure.
+	 */
+	int start();
+
+	/** Waits for the next chunk.
+	 *
+	 * @return false at the end of the file or after a read error.
+	 */
+	bool acquire(index_chunk& chunk);
+
+	/// Returns the buffer of @p chunk to the reader.
+	void release(const index_chunk& chunk);
+
+	/// Stops the reader thread and waits for it.
+	void stop();
+
+	/// Size of the payload of the file.
+	uint64_t get_file_size() const
+	{
+		return file_size;
+	}
+
+	const file_payload& get_payload() const
+	{
+		return payload;
+	}
+
+	/// Bytes read since start().
+	uint64_t get_bytes_read() const
+	{
+		return bytes_read;
+	}
+
+	/// Time the reader thread spent in read() since start() in ms.
+	double get_read_time() const
+	{
+		return read_time;
+	}
+
+	bool has_failed() const
+	{
+		return failed;
+	}
+
+private:
+	static void* reader_func(index_stream* stream);
+
+	void read_chunks();
+
+	int             fd = -1;
+
+	uint64_t        file_size = 0;
+
+	file_payload    payload;
+
+	size_t          chunk_size = 0;
+
+	uint32_t        buffer_count = 0;
+
+	input_buffer    memory;
+
+	pthread_t       reader;
+
+	bool            reader_running = false;
+
+	pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+
+	/// Signalled when a buffer is filled or the reader ends.
+	pthread_cond_t  filled_cond = PTHREAD_COND_INITIALIZER;
+
+	/// Signalled when a buffer is released or stop() is called.
+	pthread_cond_t  free_cond = PTHREAD_COND_INITIALIZER;
+
+	/// Ring of filled buffers in file order.
+	uint32_t        filled[INDEX_STREAM_BUFFERS_MAX] = {};
+
+	uint32_t        filled_first = 0;
+
+	uint32_t        filled_count = 0;
+
+	/// Counts of indices in the filled buffers.
+	uint32_t        counts[INDEX_STREAM_BUFFERS_MAX] = {};
+
+	/// Stack of free buffers.
+	uint32_t        free_buffers[INDEX_STREAM_BUFFERS_MAX] = {};
+
+	uint32_t        free_count = 0;
+
+	bool            finished = false;
+
+	bool            stopping = false;
+
+	bool            failed = false;
+
+	uint64_t        bytes_read = 0;
+
+	double          read_time = 0.0;
+
+	/// CRC32C of the payload read since start().
+	uint32_t        crc = 0;
+
+	// No copying.
+	index_stream( const index_stream& )            = delete;
+	index_stream& operator=( const index_stream& ) = delete;
+};
+
+#endif /* end of include guard: _INDEX_STREAM_H_ */
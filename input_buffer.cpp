@@ -0,0 +1,295 @@
+#include "input_buffer.h"
+#include "common.h"
+#include "file_loader.h"
+#include "file_header.h"
+#include "scope_guard.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <utility>
+
+constexpr size_t HUGETLB_PAGE_SIZE = 2 * 1024 * 1024;
+
+static size_t round_up(size_t value, size_t alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+input_buffer& input_buffer::operator=(input_buffer&& rhs)
+{
+	if (this != &rhs)
+	{
+		reset();
+		data = rhs.data;
+		size = rhs.size;
+		mapped_size = rhs.mapped_size;
+		rhs.data = nullptr;
+		rhs.size = 0;
+		rhs.mapped_size = 0;
+	}
+	return *this;
+}
+
+input_buffer input_buffer::from_heap(void* data, size_t size)
+{
+	input_buffer buffer;
+	buffer.data = data;
+	buffer.size = size;
+	return buffer;
+}
+
+input_buffer input_buffer::from_mapping(void* data, size_t size, size_t mapped_size)
+{
+	input_buffer buffer;
+	buffer.data = data;
+	buffer.size = size;
+	buffer.mapped_size = mapped_size;
+	return buffer;
+}
+
+void input_buffer::reset()
+{
+	if (data)
+	{
+		if (mapped_size)
+		{
+			munmap(data, mapped_size);
+		}
+		else
+		{
+			free(data);
+		}
+	}
+	data = nullptr;
+	size = 0;
+	mapped_size = 0;
+}
+
+static int read_to_memory(const int fd, const char* const path, const uint64_t offset, void* const data, size_t size, load_mode mode)
+{
+	if (mode != load_mode::read)
+	{
+		return load_file(path, offset, data, size, mode == load_mode::uring_direct);
+	}
+	for (size_t done = 0; done < size; )
+	{
+		const ssize_t count = pread(fd, (char*)data + done, size - done, offset + done);
+		if (count < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if (count <= 0)
+		{
+			ERR("read(%s) failed\n", path);
+			return -1;
+		}
+		done += count;
+	}
+	return 0;
+}
+
+static int load_to_buffer(const int fd, const char* const path, const uint64_t offset, size_t size, size_t padding, load_mode mode, page_mode pages, input_buffer& buffer)
+{
+	void*        input = nullptr;
+	input_buffer loaded;
+	// load_file() needs page aligned memory.
+	if (pages == page_mode::normal && mode == load_mode::read)
+	{
+		input = malloc(size + padding);
+		if (!input)
+		{
+			ERR("malloc failed for %s\n", path);
+			return -1;
+		}
+		loaded = input_buffer::from_heap(input, size);
+	}
+	else
+	{
+		page_mode obtained;
+		size_t    mapped_size;
+		input = allocate_pages(size + padding, pages, obtained, mapped_size);
+		if (!input)
+		{
+			ERR("allocation of pages failed for %s\n", path);
+			return -1;
+		}
+		loaded = input_buffer::from_mapping(input, size, mapped_size);
+	}
+	if (read_to_memory(fd, path, offset, input, size, mode) < 0)
+	{
+		return -1;
+	}
+	memset((char*)input + size, 0, padding);
+
+	buffer = std::move(loaded);
+	return 0;
+}
+
+static int load_by_mmap_hugetlb(const int fd, const char* const path, const uint64_t offset, size_t size, size_t padding, bool writable, input_buffer& buffer)
+{
+	if (offset % HUGETLB_PAGE_SIZE)
+	{
+		INFO("payload of %s at offset %lu is not aligned to huge pages\n", path, (unsigned long)offset);
+		return -1;
+	}
+	// Files on hugetlbfs always have size rounded to huge pages, so the padding
+	// is readable if it fits to the file.
+	const size_t mapped_size = round_up(size + padding, HUGETLB_PAGE_SIZE);
+	struct stat  statbuf;
+	if (fstat(fd, &statbuf) < 0 || (size_t)statbuf.st_size < offset + mapped_size)
+	{
+		INFO("%s is not on hugetlbfs\n", path);
+		return -1;
+	}
+	void* const data = mmap(
+			nullptr,
+			mapped_size,
+			writable ? PROT_READ | PROT_WRITE : PROT_READ,
+			MAP_PRIVATE | MAP_POPULATE | MAP_HUGETLB,
+			fd,
+			offset);
+	if (data == MAP_FAILED)
+	{
+		INFO("mmap(MAP_HUGETLB) of %s failed\n", path);
+		return -1;
+	}
+
+	buffer = input_buffer::from_mapping(data, size, mapped_size);
+	return 0;
+}
+
+static int load_by_mmap(const int fd, const char* const path, const uint64_t offset, size_t size, size_t padding, bool writable, input_buffer& buffer)
+{
+	// Pages of the mapping beyond the end of file raise SIGBUS, so the padding is
+	// backed by anonymous memory reserved together with the file mapping.
+	const size_t page_size = sysconf(_SC_PAGESIZE);
+	if (offset % page_size)
+	{
+		ERR("payload of %s at offset %lu is not aligned to pages for mmap\n", path, (unsigned long)offset);
+		return -1;
+	}
+	const size_t mapped_size = round_up(size + padding, page_size);
+	const int    prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+	void* const  reserved = mmap(nullptr, mapped_size, prot, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (reserved == MAP_FAILED)
+	{
+		ERR("mmap of %zu bytes for %s failed\n", mapped_size, path);
+		return -1;
+	}
+	input_buffer loaded = input_buffer::from_mapping(reserved, size, mapped_size);
+
+	if (size)
+	{
+		void* const data = mmap(reserved, size, prot, MAP_PRIVATE | MAP_POPULATE | MAP_FIXED, fd, offset);
+		if (data == MAP_FAILED)
+		{
+			ERR("mmap(%s) failed\n", path);
+			return -1;
+		}
+	}
+
+	buffer = std::move(loaded);
+	return 0;
+}
+
+static int open_input_file(const char* location, const char* filename, size_t size, char (&path)[FILE_PATH_MAX], file_payload& payload)
+{
+	if (get_data_file_path(path, sizeof(path), location, filename) < 0)
+	{
+		return -1;
+	}
+	const int fd = open(path, O_RDONLY);
+	if (fd < 0)
+	{
+		ERR("open(%s) failed\n", path);
+		return -1;
+	}
+	if (read_file_header(fd, path, payload) < 0)
+	{
+		close(fd);
+		return -1;
+	}
+	if (payload.size < size)
+	{
+		ERR("size of %s %s is lower then expected %zu\n", payload.has_header ? "payload of" : "file", path, size);
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+int read_input_buffer(
+		const char* location,
+		const char* filename,
+		size_t      size,
+		size_t      padding,
+		load_mode   mode,
+		page_mode   pages,
+		bool        writable,
+		input_buffer& buffer,
+		file_payload& payload)
+{
+	if (pages != page_mode::normal && !is_load_to_buffer(mode))
+	{
+		ERR("huge pages for %s need a load mode reading to a buffer\n", filename);
+		return -1;
+	}
+
+	char      path[FILE_PATH_MAX];
+	const int fd = open_input_file(location, filename, size, path, payload);
+	if (fd < 0)
+	{
+		return -1;
+	}
+	auto close_fd = scope_exit([&]() { close(fd); });
+
+	switch (mode)
+	{
+		case load_mode::read:
+		case load_mode::uring:
+		case load_mode::uring_direct:
+			return load_to_buffer(fd, path, payload.offset, size, padding, mode, pages, buffer);
+
+		case load_mode::mmap_hugetlb:
+			if (load_by_mmap_hugetlb(fd, path, payload.offset, size, padding, writable, buffer) == 0)
+			{
+				return 0;
+			}
+			INFO("mapping %s with regular pages\n", path);
+			return load_by_mmap(fd, path, payload.offset, size, padding, writable, buffer);
+
+		case load_mode::mmap:
+			return load_by_mmap(fd, path, payload.offset, size, padding, writable, buffer);
+	}
+
+	return -1;
+}
+
+int fill_input_buffer(
+		const char*   location,
+		const char*   filename,
+		load_mode     mode,
+		input_buffer& buffer,
+		file_payload& payload)
+{
+	if (!is_load_to_buffer(mode))
+	{
+		ERR("load mode cannot fill a buffer with %s\n", filename);
+		return -1;
+	}
+
+	char      path[FILE_PATH_MAX];
+	const int fd = open_input_file(location, filename, buffer.get_size(), path, payload);
+	if (fd < 0)
+	{
+		return -1;
+	}
+	auto close_fd = scope_exit([&]() { close(fd); });
+
+	return read_to_memory(fd, path, payload.offset, buffer.get<void>(), buffer.get_size(), mode);
+}
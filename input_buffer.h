@@ -0,0 +1,153 @@
+#ifndef _INPUT_BUFFER_H_
+#define _INPUT_BUFFER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "file_header.h"
+#include "memory.h"
+
+/// How the input files are brought into memory.
+enum class load_mode : uint32_t
+{
+	/// malloc() and read() - the data is copied from the page cache.
+	read,
+	/// mmap() of the file with MAP_POPULATE - read-only buffers share the page cache.
+	mmap,
+	/// As mmap, but with MAP_HUGETLB, falls back to mmap if the file is not on hugetlbfs.
+	mmap_hugetlb,
+	/// Parallel chunked reads by load_file() - the data is copied from the page cache.
+	uring,
+	/// As uring, but the reads bypass the page cache with O_DIRECT.
+	uring_direct,
+};
+
+/// Returns whether @p mode reads the file to memory allocated beforehand.
+inline bool is_load_to_buffer(load_mode mode)
+{
+	return mode == load_mode::read || mode == load_mode::uring || mode == load_mode::uring_direct;
+}
+
+/** Owner of a buffer with the contents of an input file.
+ *
+ * Knows whether the memory was allocated by malloc() or mapped by mmap() and
+ * releases it accordingly at destruction.
+ */
+class input_buffer
+{
+public:
+	input_buffer() = default;
+
+	~input_buffer()
+	{
+		reset();
+	}
+
+	input_buffer(input_buffer&& rhs)
+		: data(rhs.data)
+		, size(rhs.size)
+		, mapped_size(rhs.mapped_size)
+	{
+		rhs.data = nullptr;
+		rhs.size = 0;
+		rhs.mapped_size = 0;
+	}
+
+	input_buffer& operator=(input_buffer&& rhs);
+
+	/// Takes ownership of memory allocated by malloc().
+	static input_buffer from_heap(void* data, size_t size);
+
+	/// Takes ownership of @p mapped_size bytes mapped by mmap() at @p data.
+	static input_buffer from_mapping(void* data, size_t size, size_t mapped_size);
+
+	template<typename T>
+	T* get() const
+	{
+		return (T*)data;
+	}
+
+	/// Size of the file contents, without padding.
+	size_t get_size() const
+	{
+		return size;
+	}
+
+	bool is_mapped() const
+	{
+		return mapped_size != 0;
+	}
+
+	explicit operator bool() const
+	{
+		return data != nullptr;
+	}
+
+	/// Releases the buffer.
+	void reset();
+
+private:
+	void*  data = nullptr;
+
+	size_t size = 0;
+
+	/// Length of the mapping, 0 if the buffer is allocated by malloc().
+	size_t mapped_size = 0;
+
+	// No copying.
+	input_buffer( const input_buffer& )            = delete;
+	input_buffer& operator=( const input_buffer& ) = delete;
+};
+
+/** Loads first @p size bytes of the payload of a file to a buffer.
+ *
+ * The payload follows the header of the file, legacy files without a header
+ * are the payload as a whole.
+ *
+ * @param location Directory with the file.
+ * @param filename Name of the file.
+ * @param size     Count of bytes to load, the payload has to be at least that large.
+ * @param padding  Count of readable bytes required after the end of the data.
+ * @param mode     How to load the file.
+ * @param pages    Size of pages backing the buffer, page_mode::normal keeps
+ *                 what @p mode gives. Other page modes need a mode for which
+ *                 is_load_to_buffer() holds.
+ * @param writable Whether the buffer is going to be modified. Writable mappings
+ *                 are private, so the pages are copied when populated.
+ * @param buffer   Output buffer.
+ * @param payload  Output with the header and the location of the payload.
+ *
+ * @return 0 on success, -1 on failure.
+ */
+int read_input_buffer(
+		const char* location,
+		const char* filename,
+		size_t      size,
+		size_t      padding,
+		load_mode   mode,
+		page_mode   pages,
+		bool        writable,
+		input_buffer& buffer,
+		file_payload& payload);
+
+/** Loads first bytes of the payload of a file to an allocated buffer.
+ *
+ * Lets the caller decide the placement of the memory, e.g. to read the file
+ * straight to memory bound to a NUMA node.
+ *
+ * @param location Directory with the file.
+ * @param filename Name of the file.
+ * @param mode     How to load the file, is_load_to_buffer() has to hold.
+ * @param buffer   Buffer mapped by mmap(), get_size() bytes are loaded to it.
+ * @param payload  Output with the header and the location of the payload.
+ *
+ * @return 0 on success, -1 on failure.
+ */
+int fill_input_buffer(
+		const char*   location,
+		const char*   filename,
+		load_mode     mode,
+		input_buffer& buffer,
+		file_payload& payload);
+
+#endif /* end of include guard: _INPUT_BUFFER_H_ */
@@ -0,0 +1,247 @@
+#include "kernels.h"
+#include "common.h"
+
+#include <immintrin.h>
+
+/// Gathers table elements of 8 masked indices.
+template<table_format FORMAT>
+static __m256i gather_elements(const void* const table, const __m256i indices)
+{
+	// Each lane loads 32 bits at the element, the rest of the lane belongs to the next elements.
+	if constexpr (FORMAT == table_format::u8)
+	{
+		return _mm256_and_si256(_mm256_i32gather_epi32((const int*)table, indices, 1), _mm256_set1_epi32(0xFF));
+	}
+	else if constexpr (FORMAT == table_format::u12)
+	{
+		// Element i starts at byte i * 3 / 2, odd elements at its upper nibble.
+		const __m256i offsets = _mm256_srli_epi32(_mm256_add_epi32(indices, _mm256_slli_epi32(indices, 1)), 1);
+		const __m256i shifts = _mm256_slli_epi32(_mm256_and_si256(indices, _mm256_set1_epi32(1)), 2);
+		const __m256i packed = _mm256_i32gather_epi32((const int*)table, offsets, 1);
+		return _mm256_and_si256(_mm256_srlv_epi32(packed, shifts), _mm256_set1_epi32(0xFFF));
+	}
+	else if constexpr (FORMAT == table_format::u16)
+	{
+		return _mm256_and_si256(_mm256_i32gather_epi32((const int*)table, indices, 2), _mm256_set1_epi32(0xFFFF));
+	}
+	else
+	{
+		return _mm256_i32gather_epi32((const int*)table, indices, 4);
+	}
+}
+
+/// Gathers table elements of 4 masked 64-bit indices.
+template<table_format FORMAT>
+static __m128i gather_elements_wide(const void* const table, const __m256i indices)
+{
+	if constexpr (FORMAT == table_format::u8)
+	{
+		return _mm_and_si128(_mm256_i64gather_epi32((const int*)table, indices, 1), _mm_set1_epi32(0xFF));
+	}
+	else if constexpr (FORMAT == table_format::u12)
+	{
+		const __m256i offsets = _mm256_srli_epi64(_mm256_add_epi64(indices, _mm256_slli_epi64(indices, 1)), 1);
+		// The shifts of the 64-bit lanes are moved to the low 32-bit lanes.
+		const __m256i shifts = _mm256_slli_epi64(_mm256_and_si256(indices, _mm256_set1_epi64x(1)), 2);
+		const __m128i shifts32 = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(shifts, _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6)));
+		const __m128i packed = _mm256_i64gather_epi32((const int*)table, offsets, 1);
+		return _mm_and_si128(_mm_srlv_epi32(packed, shifts32), _mm_set1_epi32(0xFFF));
+	}
+	else if constexpr (FORMAT == table_format::u16)
+	{
+		return _mm_and_si128(_mm256_i64gather_epi32((const int*)table, indices, 2), _mm_set1_epi32(0xFFFF));
+	}
+	else
+	{
+		return _mm256_i64gather_epi32((const int*)table, indices, 4);
+	}
+}
+
+/// Table indexing of the kernel_context broadcast to vectors.
+struct vector_indexing_avx2
+{
+	__m256i mask;
+
+	__m256i mask_wide;
+
+	__m128i shift;
+
+	/// Count of elements of narrow tables, low and high words of the count of wide tables.
+	__m256i count;
+
+	__m256i count_low;
+
+	__m256i count_high;
+
+	__m256i divisor;
+
+	__m256i magic;
+
+	__m128i magic_shift;
+};
+
+static vector_indexing_avx2 broadcast_indexing(const table_indexing& indexing)
+{
+	vector_indexing_avx2 result;
+	result.mask = _mm256_set1_epi32((uint32_t)indexing.mask);
+	result.mask_wide = _mm256_set1_epi64x(indexing.mask);
+	result.shift = _mm_cvtsi32_si128(indexing.shift);
+	result.count = _mm256_set1_epi32((uint32_t)indexing.count);
+	result.count_low = _mm256_set1_epi64x((uint32_t)indexing.count);
+	result.count_high = _mm256_set1_epi64x(indexing.count >> 32);
+	result.divisor = _mm256_set1_epi32(indexing.divisor);
+	result.magic = _mm256_set1_epi32(indexing.magic);
+	result.magic_shift = _mm_cvtsi32_si128(indexing.magic_shift);
+	return result;
+}
+
+/// High words of the products of unsigned 32-bit lanes.
+static __m256i mulhi_epu32(const __m256i a, const __m256i b)
+{
+	const __m256i even = _mm256_srli_epi64(_mm256_mul_epu32(a, b), 32);
+	const __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32));
+	return _mm256_blend_epi32(even, odd, 0xAA);
+}
+
+/// Remainders of 8 indices divided by the divisor of the divide reduction, see get_quotient().
+static __m256i get_remainders(const __m256i indices, const vector_indexing_avx2& indexing)
+{
+	const __m256i high = mulhi_epu32(indices, indexing.magic);
+	const __m256i quotients = _mm256_srl_epi32(_mm256_add_epi32(_mm256_srli_epi32(_mm256_sub_epi32(indices, high), 1), high), indexing.magic_shift);
+	return _mm256_sub_epi32(indices, _mm256_mullo_epi32(quotients, indexing.divisor));
+}
+
+/// Reduces 8 indices to 32-bit table indices as get_table_index() does.
+template<table_reduction REDUCTION>
+static __m256i get_table_indices(const __m256i indices, const vector_indexing_avx2& indexing)
+{
+	if constexpr (REDUCTION == table_reduction::mask)
+	{
+		return _mm256_and_si256(indices, indexing.mask);
+	}
+	else if constexpr (REDUCTION == table_reduction::multiply)
+	{
+		return mulhi_epu32(indices, indexing.count);
+	}
+	else
+	{
+		return get_remainders(indices, indexing);
+	}
+}
+
+/** Reduces 4 indices to 64-bit table indices as get_table_index() does.
+ *
+ * The indices of the divide reduction are already the remainders.
+ */
+template<table_reduction REDUCTION>
+static __m256i get_table_indices_wide(const __m128i indices, const vector_indexing_avx2& indexing)
+{
+	const __m256i wide = _mm256_cvtepu32_epi64(indices);
+	if constexpr (REDUCTION == table_reduction::mask)
+	{
+		return _mm256_and_si256(_mm256_sll_epi64(wide, indexing.shift), indexing.mask_wide);
+	}
+	else if constexpr (REDUCTION == table_reduction::multiply)
+	{
+		const __m256i low = _mm256_srli_epi64(_mm256_mul_epu32(wide, indexing.count_low), 32);
+		return _mm256_add_epi64(_mm256_mul_epu32(wide, indexing.count_high), low);
+	}
+	else
+	{
+		return _mm256_sll_epi64(wide, indexing.shift);
+	}
+}
+
+/// Gathers table elements of 8 indices widened by get_table_index().
+template<table_format FORMAT, table_reduction REDUCTION>
+static __m256i gather_elements_wide(const void* const table, __m256i indices, const vector_indexing_avx2& indexing)
+{
+	if constexpr (REDUCTION == table_reduction::divide)
+	{
+		indices = get_remainders(indices, indexing);
+	}
+	const __m256i low = get_table_indices_wide<REDUCTION>(_mm256_castsi256_si128(indices), indexing);
+	const __m256i high = get_table_indices_wide<REDUCTION>(_mm256_extracti128_si256(indices, 1), indexing);
+	return _mm256_set_m128i(gather_elements_wide<FORMAT>(table, high), gather_elements_wide<FORMAT>(table, low));
+}
+
+template<table_format FORMAT, table_reduction REDUCTION, typename TABLE_INDEX>
+static uint16_t walk_avx2(const kernel_context& ctx)
+{
+	const __m256i         index_xor = _mm256_set1_epi32(INDEX_XOR_VAL);
+	const __m256i         thread_id = _mm256_set1_epi32(ctx.thread_id);
+	const vector_indexing_avx2 indexing = broadcast_indexing(ctx.indexing);
+	const __m256i         add_val = _mm256_set1_epi32(TABLE_ADD_VAL);
+	__m256i               values = _mm256_set1_epi32(TABLE_XOR_VAL);
+	uint32_t              index = 0;
+	for (; index + 8 <= ctx.count_of_indices; index += 8)
+	{
+		__m256i* const indices_ptr = (__m256i*)&ctx.indices[index];
+		const __m256i  indices = _mm256_add_epi32(_mm256_xor_si256(_mm256_loadu_si256(indices_ptr), index_xor), thread_id);
+
+		__m256i elements;
+		if constexpr (sizeof(TABLE_INDEX) == sizeof(uint32_t))
+		{
+			elements = gather_elements<FORMAT>(ctx.table, get_table_indices<REDUCTION>(indices, indexing));
+		}
+		else
+		{
+			elements = gather_elements_wide<FORMAT, REDUCTION>(ctx.table, indices, indexing);
+		}
+		values = _mm256_and_si256(_mm256_xor_si256(values, elements), add_val);
+
+		_mm256_storeu_si256(indices_ptr, indices);
+	}
+
+	__m128i value = _mm_xor_si128(_mm256_castsi256_si128(values), _mm256_extracti128_si256(values, 1));
+	value = _mm_xor_si128(value, _mm_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2)));
+	value = _mm_xor_si128(value, _mm_shuffle_epi32(value, _MM_SHUFFLE(2, 3, 0, 1)));
+
+	return (uint16_t)_mm_cvtsi128_si32(value) ^ kernel_tail(ctx, index);
+}
+
+template<table_reduction REDUCTION, typename TABLE_INDEX>
+static uint16_t walk_avx2(const kernel_context& ctx)
+{
+	switch (ctx.format)
+	{
+		case table_format::u8:
+			return walk_avx2<table_format::u8, REDUCTION, TABLE_INDEX>(ctx);
+
+		case table_format::u12:
+			return walk_avx2<table_format::u12, REDUCTION, TABLE_INDEX>(ctx);
+
+		case table_format::u16:
+			return walk_avx2<table_format::u16, REDUCTION, TABLE_INDEX>(ctx);
+
+		case table_format::u32:
+			return walk_avx2<table_format::u32, REDUCTION, TABLE_INDEX>(ctx);
+	}
+	return 0;
+}
+
+template<typename TABLE_INDEX>
+static uint16_t walk_avx2(const kernel_context& ctx)
+{
+	switch (ctx.indexing.reduction)
+	{
+		case table_reduction::mask:
+			return walk_avx2<table_reduction::mask, TABLE_INDEX>(ctx);
+
+		case table_reduction::multiply:
+			return walk_avx2<table_reduction::multiply, TABLE_INDEX>(ctx);
+
+		case table_reduction::divide:
+			return walk_avx2<table_reduction::divide, TABLE_INDEX>(ctx);
+	}
+	return 0;
+}
+
+uint16_t kernel_avx2(const kernel_context& ctx)
+{
+	if (ctx.wide_indices)
+	{
+		return walk_avx2<uint64_t>(ctx);
+	}
+	return walk_avx2<uint32_t>(ctx);
+}
@@ -0,0 +1,246 @@
+#include "kernels.h"
+#include "common.h"
+
+#include <immintrin.h>
+
+/// Gathers table elements of 16 masked indices.
+template<table_format FORMAT>
+static __m512i gather_elements(const void* const table, const __m512i indices)
+{
+	// Each lane loads 32 bits at the element, the rest of the lane belongs to the next elements.
+	if constexpr (FORMAT == table_format::u8)
+	{
+		return _mm512_and_si512(_mm512_i32gather_epi32(indices, table, 1), _mm512_set1_epi32(0xFF));
+	}
+	else if constexpr (FORMAT == table_format::u12)
+	{
+		// Element i starts at byte i * 3 / 2, odd elements at its upper nibble.
+		const __m512i offsets = _mm512_srli_epi32(_mm512_add_epi32(indices, _mm512_slli_epi32(indices, 1)), 1);
+		const __m512i shifts = _mm512_slli_epi32(_mm512_and_si512(indices, _mm512_set1_epi32(1)), 2);
+		const __m512i packed = _mm512_i32gather_epi32(offsets, table, 1);
+		return _mm512_and_si512(_mm512_srlv_epi32(packed, shifts), _mm512_set1_epi32(0xFFF));
+	}
+	else if constexpr (FORMAT == table_format::u16)
+	{
+		return _mm512_and_si512(_mm512_i32gather_epi32(indices, table, 2), _mm512_set1_epi32(0xFFFF));
+	}
+	else
+	{
+		return _mm512_i32gather_epi32(indices, table, 4);
+	}
+}
+
+/// Gathers table elements of 8 masked 64-bit indices.
+template<table_format FORMAT>
+static __m256i gather_elements_wide(const void* const table, const __m512i indices)
+{
+	if constexpr (FORMAT == table_format::u8)
+	{
+		return _mm256_and_si256(_mm512_i64gather_epi32(indices, table, 1), _mm256_set1_epi32(0xFF));
+	}
+	else if constexpr (FORMAT == table_format::u12)
+	{
+		const __m512i offsets = _mm512_srli_epi64(_mm512_add_epi64(indices, _mm512_slli_epi64(indices, 1)), 1);
+		const __m256i shifts = _mm512_cvtepi64_epi32(_mm512_slli_epi64(_mm512_and_si512(indices, _mm512_set1_epi64(1)), 2));
+		const __m256i packed = _mm512_i64gather_epi32(offsets, table, 1);
+		return _mm256_and_si256(_mm256_srlv_epi32(packed, shifts), _mm256_set1_epi32(0xFFF));
+	}
+	else if constexpr (FORMAT == table_format::u16)
+	{
+		return _mm256_and_si256(_mm512_i64gather_epi32(indices, table, 2), _mm256_set1_epi32(0xFFFF));
+	}
+	else
+	{
+		return _mm512_i64gather_epi32(indices, table, 4);
+	}
+}
+
+/// Table indexing of the kernel_context broadcast to vectors.
+struct vector_indexing_avx512
+{
+	__m512i mask;
+
+	__m512i mask_wide;
+
+	__m128i shift;
+
+	/// Count of elements of narrow tables, low and high words of the count of wide tables.
+	__m512i count;
+
+	__m512i count_low;
+
+	__m512i count_high;
+
+	__m512i divisor;
+
+	__m512i magic;
+
+	__m128i magic_shift;
+};
+
+static vector_indexing_avx512 broadcast_indexing(const table_indexing& indexing)
+{
+	vector_indexing_avx512 result;
+	result.mask = _mm512_set1_epi32((uint32_t)indexing.mask);
+	result.mask_wide = _mm512_set1_epi64(indexing.mask);
+	result.shift = _mm_cvtsi32_si128(indexing.shift);
+	result.count = _mm512_set1_epi32((uint32_t)indexing.count);
+	result.count_low = _mm512_set1_epi64((uint32_t)indexing.count);
+	result.count_high = _mm512_set1_epi64(indexing.count >> 32);
+	result.divisor = _mm512_set1_epi32(indexing.divisor);
+	result.magic = _mm512_set1_epi32(indexing.magic);
+	result.magic_shift = _mm_cvtsi32_si128(indexing.magic_shift);
+	return result;
+}
+
+/// High words of the products of unsigned 32-bit lanes.
+static __m512i mulhi_epu32(const __m512i a, const __m512i b)
+{
+	const __m512i even = _mm512_srli_epi64(_mm512_mul_epu32(a, b), 32);
+	const __m512i odd = _mm512_mul_epu32(_mm512_srli_epi64(a, 32), _mm512_srli_epi64(b, 32));
+	return _mm512_mask_blend_epi32(0xAAAA, even, odd);
+}
+
+/// Remainders of 16 indices divided by the divisor of the divide reduction, see get_quotient().
+static __m512i get_remainders(const __m512i indices, const vector_indexing_avx512& indexing)
+{
+	const __m512i high = mulhi_epu32(indices, indexing.magic);
+	const __m512i quotients = _mm512_srl_epi32(_mm512_add_epi32(_mm512_srli_epi32(_mm512_sub_epi32(indices, high), 1), high), indexing.magic_shift);
+	return _mm512_sub_epi32(indices, _mm512_mullo_epi32(quotients, indexing.divisor));
+}
+
+/// Reduces 16 indices to 32-bit table indices as get_table_index() does.
+template<table_reduction REDUCTION>
+static __m512i get_table_indices(const __m512i indices, const vector_indexing_avx512& indexing)
+{
+	if constexpr (REDUCTION == table_reduction::mask)
+	{
+		return _mm512_and_si512(indices, indexing.mask);
+	}
+	else if constexpr (REDUCTION == table_reduction::multiply)
+	{
+		return mulhi_epu32(indices, indexing.count);
+	}
+	else
+	{
+		return get_remainders(indices, indexing);
+	}
+}
+
+/** Reduces 8 indices to 64-bit table indices as get_table_index() does.
+ *
+ * The indices of the divide reduction are already the remainders.
+ */
+template<table_reduction REDUCTION>
+static __m512i get_table_indices_wide(const __m256i indices, const vector_indexing_avx512& indexing)
+{
+	const __m512i wide = _mm512_cvtepu32_epi64(indices);
+	if constexpr (REDUCTION == table_reduction::mask)
+	{
+		return _mm512_and_si512(_mm512_sll_epi64(wide, indexing.shift), indexing.mask_wide);
+	}
+	else if constexpr (REDUCTION == table_reduction::multiply)
+	{
+		const __m512i low = _mm512_srli_epi64(_mm512_mul_epu32(wide, indexing.count_low), 32);
+		return _mm512_add_epi64(_mm512_mul_epu32(wide, indexing.count_high), low);
+	}
+	else
+	{
+		return _mm512_sll_epi64(wide, indexing.shift);
+	}
+}
+
+/// Gathers table elements of 16 indices widened by get_table_index().
+template<table_format FORMAT, table_reduction REDUCTION>
+static __m512i gather_elements_wide(const void* const table, __m512i indices, const vector_indexing_avx512& indexing)
+{
+	if constexpr (REDUCTION == table_reduction::divide)
+	{
+		indices = get_remainders(indices, indexing);
+	}
+	const __m512i low = get_table_indices_wide<REDUCTION>(_mm512_castsi512_si256(indices), indexing);
+	const __m512i high = get_table_indices_wide<REDUCTION>(_mm512_extracti64x4_epi64(indices, 1), indexing);
+	return _mm512_inserti64x4(_mm512_castsi256_si512(gather_elements_wide<FORMAT>(table, low)), gather_elements_wide<FORMAT>(table, high), 1);
+}
+
+template<table_format FORMAT, table_reduction REDUCTION, typename TABLE_INDEX>
+static uint16_t walk_avx512(const kernel_context& ctx)
+{
+	const __m512i         index_xor = _mm512_set1_epi32(INDEX_XOR_VAL);
+	const __m512i         thread_id = _mm512_set1_epi32(ctx.thread_id);
+	const vector_indexing_avx512 indexing = broadcast_indexing(ctx.indexing);
+	const __m512i         add_val = _mm512_set1_epi32(TABLE_ADD_VAL);
+	__m512i               values = _mm512_set1_epi32(TABLE_XOR_VAL);
+	uint32_t              index = 0;
+	for (; index + 16 <= ctx.count_of_indices; index += 16)
+	{
+		void* const   indices_ptr = &ctx.indices[index];
+		const __m512i indices = _mm512_add_epi32(_mm512_xor_si512(_mm512_loadu_si512(indices_ptr), index_xor), thread_id);
+
+		__m512i elements;
+		if constexpr (sizeof(TABLE_INDEX) == sizeof(uint32_t))
+		{
+			elements = gather_elements<FORMAT>(ctx.table, get_table_indices<REDUCTION>(indices, indexing));
+		}
+		else
+		{
+			elements = gather_elements_wide<FORMAT, REDUCTION>(ctx.table, indices, indexing);
+		}
+		values = _mm512_and_si512(_mm512_xor_si512(values, elements), add_val);
+
+		_mm512_storeu_si512(indices_ptr, indices);
+	}
+
+	__m256i value8 = _mm256_xor_si256(_mm512_castsi512_si256(values), _mm512_extracti64x4_epi64(values, 1));
+	__m128i value = _mm_xor_si128(_mm256_castsi256_si128(value8), _mm256_extracti128_si256(value8, 1));
+	value = _mm_xor_si128(value, _mm_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2)));
+	value = _mm_xor_si128(value, _mm_shuffle_epi32(value, _MM_SHUFFLE(2, 3, 0, 1)));
+
+	return (uint16_t)_mm_cvtsi128_si32(value) ^ kernel_tail(ctx, index);
+}
+
+template<table_reduction REDUCTION, typename TABLE_INDEX>
+static uint16_t walk_avx512(const kernel_context& ctx)
+{
+	switch (ctx.format)
+	{
+		case table_format::u8:
+			return walk_avx512<table_format::u8, REDUCTION, TABLE_INDEX>(ctx);
+
+		case table_format::u12:
+			return walk_avx512<table_format::u12, REDUCTION, TABLE_INDEX>(ctx);
+
+		case table_format::u16:
+			return walk_avx512<table_format::u16, REDUCTION, TABLE_INDEX>(ctx);
+
+		case table_format::u32:
+			return walk_avx512<table_format::u32, REDUCTION, TABLE_INDEX>(ctx);
+	}
+	return 0;
+}
+
+template<typename TABLE_INDEX>
+static uint16_t walk_avx512(const kernel_context& ctx)
+{
+	switch (ctx.indexing.reduction)
+	{
+		case table_reduction::mask:
+			return walk_avx512<table_reduction::mask, TABLE_INDEX>(ctx);
+
+		case table_reduction::multiply:
+			return walk_avx512<table_reduction::multiply, TABLE_INDEX>(ctx);
+
+		case table_reduction::divide:
+			return walk_avx512<table_reduction::divide, TABLE_INDEX>(ctx);
+	}
+	return 0;
+}
+
+uint16_t kernel_avx512(const kernel_context& ctx)
+{
+	if (ctx.wide_indices)
+	{
+		return walk_avx512<uint64_t>(ctx);
+	}
+	return walk_avx512<uint32_t>(ctx);
+}
@@ -0,0 +1,145 @@
+#include "kernels.h"
+#include "common.h"
+
+/** Returns the table index of a state transition.
+ *
+ * The DFA needs the transitions reduced by the remainder, the multiply-shift
+ * would map the transitions of the small states to the first elements of the
+ * table, so the multiply reduction divides by the count. The divide reduction
+ * multiplies by the reciprocal, which serves only 32-bit transitions.
+ */
+template<table_reduction REDUCTION, typename TABLE_INDEX>
+static inline TABLE_INDEX get_transition_index(TABLE_INDEX transition, const table_indexing& indexing)
+{
+	if constexpr (REDUCTION == table_reduction::mask)
+	{
+		return transition & (TABLE_INDEX)indexing.mask;
+	}
+	else if constexpr (REDUCTION == table_reduction::divide && sizeof(TABLE_INDEX) == sizeof(uint32_t))
+	{
+		return transition - get_quotient(transition, indexing) * indexing.divisor;
+	}
+	else
+	{
+		return transition % (TABLE_INDEX)indexing.count;
+	}
+}
+
+/** Walks the table as a DFA driven by STREAMS independent inputs.
+ *
+ * The indices are input symbols, the input is split into STREAMS contiguous
+ * parts and each part drives its own state starting at state 0. The next
+ * state is table[state * alphabet_size + symbol], so the accesses of each
+ * stream form a dependency chain and only the streams run in parallel.
+ * The indices are not modified. The table index is computed in TABLE_INDEX,
+ * so wide indices reach the states of tables with more than 2^32 elements.
+ *
+ * @return XOR of the final states.
+ */
+template<uint32_t STREAMS, table_format FORMAT, table_reduction REDUCTION, typename TABLE_INDEX>
+static uint16_t walk_chain(const kernel_context& ctx)
+{
+	const uint32_t* const input = ctx.indices;
+	const void* const     table = ctx.table;
+	const table_indexing  indexing = ctx.indexing;
+	const TABLE_INDEX     alphabet_size = ctx.alphabet_size;
+	const uint32_t        symbol_mask = ctx.alphabet_size - 1;
+	const uint32_t        stream_length = ctx.count_of_indices / STREAMS;
+	uint32_t              states[STREAMS] = {};
+
+	for (uint32_t position = 0; position < stream_length; ++position)
+	{
+		for (uint32_t stream = 0; stream < STREAMS; ++stream)
+		{
+			const uint32_t symbol = input[stream * stream_length + position] & symbol_mask;
+			states[stream] = load_table_element<FORMAT>(table, get_transition_index<REDUCTION>(states[stream] * alphabet_size + symbol, indexing));
+		}
+	}
+
+	// Symbols which do not fill all streams continue the first stream.
+	for (uint32_t index = stream_length * STREAMS; index < ctx.count_of_indices; ++index)
+	{
+		const uint32_t symbol = input[index] & symbol_mask;
+		states[0] = load_table_element<FORMAT>(table, get_transition_index<REDUCTION>(states[0] * alphabet_size + symbol, indexing));
+	}
+
+	uint16_t value = 0;
+	for (uint32_t stream = 0; stream < STREAMS; ++stream)
+	{
+		value ^= states[stream];
+	}
+
+	return value;
+}
+
+template<table_format FORMAT, table_reduction REDUCTION, typename TABLE_INDEX>
+static uint16_t walk_chain(const kernel_context& ctx)
+{
+	switch (ctx.stream_count)
+	{
+		case 1:
+			return walk_chain<1, FORMAT, REDUCTION, TABLE_INDEX>(ctx);
+
+		case 2:
+			return walk_chain<2, FORMAT, REDUCTION, TABLE_INDEX>(ctx);
+
+		case 4:
+			return walk_chain<4, FORMAT, REDUCTION, TABLE_INDEX>(ctx);
+
+		case 8:
+			return walk_chain<8, FORMAT, REDUCTION, TABLE_INDEX>(ctx);
+
+		case 16:
+			return walk_chain<16, FORMAT, REDUCTION, TABLE_INDEX>(ctx);
+
+		case 32:
+			return walk_chain<32, FORMAT, REDUCTION, TABLE_INDEX>(ctx);
+	}
+	return 0;
+}
+
+template<table_reduction REDUCTION, typename TABLE_INDEX>
+static uint16_t walk_chain(const kernel_context& ctx)
+{
+	switch (ctx.format)
+	{
+		case table_format::u8:
+			return walk_chain<table_format::u8, REDUCTION, TABLE_INDEX>(ctx);
+
+		case table_format::u12:
+			return walk_chain<table_format::u12, REDUCTION, TABLE_INDEX>(ctx);
+
+		case table_format::u16:
+			return walk_chain<table_format::u16, REDUCTION, TABLE_INDEX>(ctx);
+
+		case table_format::u32:
+			return walk_chain<table_format::u32, REDUCTION, TABLE_INDEX>(ctx);
+	}
+	return 0;
+}
+
+template<typename TABLE_INDEX>
+static uint16_t walk_chain(const kernel_context& ctx)
+{
+	switch (ctx.indexing.reduction)
+	{
+		case table_reduction::mask:
+			return walk_chain<table_reduction::mask, TABLE_INDEX>(ctx);
+
+		case table_reduction::multiply:
+			return walk_chain<table_reduction::multiply, TABLE_INDEX>(ctx);
+
+		case table_reduction::divide:
+			return walk_chain<table_reduction::divide, TABLE_INDEX>(ctx);
+	}
+	return 0;
+}
+
+uint16_t kernel_chain(const kernel_context& ctx)
+{
+	if (ctx.wide_indices)
+	{
+		return walk_chain<uint64_t>(ctx);
+	}
+	return walk_chain<uint32_t>(ctx);
+}
@@ -0,0 +1,100 @@
+#include "kernels.h"
+#include "common.h"
+#include "latency_histogram.h"
+
+#include <x86intrin.h>
+
+/** Walks the indices as the scalar kernel and times every latency_interval-th lookup.
+ *
+ * rdtscp waits until the previous instructions complete, but does not keep the
+ * following ones from starting before it. Each rdtscp is therefore followed
+ * by lfence: the first keeps the timed load from issuing before the start
+ * timestamp is read, the second keeps the following instructions from
+ * starting before the end timestamp. The difference of the timestamps is the
+ * latency of the load plus the constant overhead of the sequence.
+ */
+template<table_format FORMAT, table_reduction REDUCTION, typename TABLE_INDEX>
+static uint16_t walk_latency(const kernel_context& ctx)
+{
+	uint32_t* const      indices_arr = ctx.indices;
+	const void* const    table = ctx.table;
+	const table_indexing indexing = ctx.indexing;
+	const uint32_t       thread_id = ctx.thread_id;
+	latency_histogram&   histogram = *ctx.histogram;
+	uint32_t             countdown = ctx.latency_interval;
+	uint16_t             value = 0;
+	for (uint32_t index = 0; index < ctx.count_of_indices; ++index)
+	{
+		const uint32_t table_index = (indices_arr[index] ^ INDEX_XOR_VAL) + thread_id;
+		indices_arr[index] = table_index;
+
+		uint32_t element;
+		if (--countdown)
+		{
+			element = load_table_element<FORMAT>(table, get_table_index<REDUCTION, TABLE_INDEX>(table_index, indexing));
+		}
+		else
+		{
+			countdown = ctx.latency_interval;
+			unsigned int aux;
+			const uint64_t start = __rdtscp(&aux);
+			_mm_lfence();
+			// Compiler barriers keep the load between the timestamps.
+			__asm__ volatile("" ::: "memory");
+			element = load_table_element<FORMAT>(table, get_table_index<REDUCTION, TABLE_INDEX>(table_index, indexing));
+			__asm__ volatile("" :: "r"(element) : "memory");
+			const uint64_t end = __rdtscp(&aux);
+			_mm_lfence();
+			histogram.record(end - start);
+		}
+		value = (value ^ element) & TABLE_ADD_VAL;
+	}
+
+	return value;
+}
+
+template<table_reduction REDUCTION, typename TABLE_INDEX>
+static uint16_t walk_latency(const kernel_context& ctx)
+{
+	switch (ctx.format)
+	{
+		case table_format::u8:
+			return walk_latency<table_format::u8, REDUCTION, TABLE_INDEX>(ctx);
+
+		case table_format::u12:
+			return walk_latency<table_format::u12, REDUCTION, TABLE_INDEX>(ctx);
+
+		case table_format::u16:
+			return walk_latency<table_format::u16, REDUCTION, TABLE_INDEX>(ctx);
+
+		case table_format::u32:
+			return walk_latency<table_format::u32, REDUCTION, TABLE_INDEX>(ctx);
+	}
+	return 0;
+}
+
+template<typename TABLE_INDEX>
+static uint16_t walk_latency(const kernel_context& ctx)
+{
+	switch (ctx.indexing.reduction)
+	{
+		case table_reduction::mask:
+			return walk_latency<table_reduction::mask, TABLE_INDEX>(ctx);
+
+		case table_reduction::multiply:
+			return walk_latency<table_reduction::multiply, TABLE_INDEX>(ctx);
+
+		case table_reduction::divide:
+			return walk_latency<table_reduction::divide, TABLE_INDEX>(ctx);
+	}
+	return 0;
+}
+
+uint16_t kernel_latency(const kernel_context& ctx)
+{
+	if (ctx.wide_indices)
+	{
+		return walk_latency<uint64_t>(ctx);
+	}
+	return walk_latency<uint32_t>(ctx);
+}
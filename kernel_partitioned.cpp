@@ -0,0 +1,130 @@
+#include "kernels.h"
+#include "common.h"
+
+#include <string.h>
+
+size_t get_partition_scratch_count(uint32_t batch_size, uint32_t partition_bits)
+{
+	// Bucket offsets, sorted indices, their positions and the results.
+	return ((size_t)1 << partition_bits) + 1 + (size_t)batch_size * 3;
+}
+
+uint32_t get_partition_bits(size_t table_size)
+{
+	uint32_t partition_bits = 0;
+	while (partition_bits < PARTITION_BITS_MAX && (table_size >> partition_bits) > PARTITION_REGION_SIZE)
+	{
+		partition_bits++;
+	}
+	return partition_bits;
+}
+
+/** Looks up the table by batches of indices sorted to buckets by high bits.
+ *
+ * Each batch is partitioned by a counting sort, so the lookups of each bucket
+ * hit one region of the table, which stays in cache while the bucket is
+ * processed. The loaded elements are scattered back to the original order.
+ * The sorted indices are kept 32-bit, their table indices are computed again
+ * at the lookup.
+ */
+template<table_format FORMAT, table_reduction REDUCTION, typename TABLE_INDEX>
+static uint16_t walk_partitioned(const kernel_context& ctx)
+{
+	uint32_t* const      indices_arr = ctx.indices;
+	const void* const    table = ctx.table;
+	const table_indexing indexing = ctx.indexing;
+	const uint32_t       thread_id = ctx.thread_id;
+	const uint32_t       bucket_count = 1u << ctx.partition_bits;
+	const uint32_t       table_bits = indexing.count > 1 ? 64 - __builtin_clzll(indexing.count - 1) : 0;
+	const uint32_t       bucket_shift = table_bits > ctx.partition_bits ? table_bits - ctx.partition_bits : 0;
+	const uint32_t       batch_size = ctx.batch_size;
+	uint32_t* const      bucket_offsets = ctx.scratch;
+	uint32_t* const      sorted_indices = bucket_offsets + bucket_count + 1;
+	uint32_t* const      sorted_positions = sorted_indices + batch_size;
+	uint32_t* const      results = sorted_positions + batch_size;
+	uint16_t             value = 0;
+
+	for (uint32_t first = 0; first < ctx.count_of_indices; first += batch_size)
+	{
+		uint32_t* const batch = indices_arr + first;
+		const uint32_t  batch_count = ctx.count_of_indices - first < batch_size ? ctx.count_of_indices - first : batch_size;
+
+		// Counts of bucket b are at b + 1, so the prefix sum gives the start of each bucket.
+		memset(bucket_offsets, 0, (bucket_count + 1) * sizeof(uint32_t));
+		for (uint32_t i = 0; i < batch_count; ++i)
+		{
+			const uint32_t table_index = (batch[i] ^ INDEX_XOR_VAL) + thread_id;
+			batch[i] = table_index;
+			bucket_offsets[(get_table_index<REDUCTION, TABLE_INDEX>(table_index, indexing) >> bucket_shift) + 1]++;
+		}
+		for (uint32_t bucket = 0; bucket < bucket_count; ++bucket)
+		{
+			bucket_offsets[bucket + 1] += bucket_offsets[bucket];
+		}
+		for (uint32_t i = 0; i < batch_count; ++i)
+		{
+			const TABLE_INDEX table_index = get_table_index<REDUCTION, TABLE_INDEX>(batch[i], indexing);
+			const uint32_t    sorted = bucket_offsets[table_index >> bucket_shift]++;
+			sorted_indices[sorted] = batch[i];
+			sorted_positions[sorted] = i;
+		}
+
+		for (uint32_t sorted = 0; sorted < batch_count; ++sorted)
+		{
+			results[sorted_positions[sorted]] = load_table_element<FORMAT>(table, get_table_index<REDUCTION, TABLE_INDEX>(sorted_indices[sorted], indexing));
+		}
+
+		for (uint32_t i = 0; i < batch_count; ++i)
+		{
+			value = (value ^ results[i]) & TABLE_ADD_VAL;
+		}
+	}
+
+	return value;
+}
+
+template<table_reduction REDUCTION, typename TABLE_INDEX>
+static uint16_t walk_partitioned(const kernel_context& ctx)
+{
+	switch (ctx.format)
+	{
+		case table_format::u8:
+			return walk_partitioned<table_format::u8, REDUCTION, TABLE_INDEX>(ctx);
+
+		case table_format::u12:
+			return walk_partitioned<table_format::u12, REDUCTION, TABLE_INDEX>(ctx);
+
+		case table_format::u16:
+			return walk_partitioned<table_format::u16, REDUCTION, TABLE_INDEX>(ctx);
+
+		case table_format::u32:
+			return walk_partitioned<table_format::u32, REDUCTION, TABLE_INDEX>(ctx);
+	}
+	return 0;
+}
+
+template<typename TABLE_INDEX>
+static uint16_t walk_partitioned(const kernel_context& ctx)
+{
+	switch (ctx.indexing.reduction)
+	{
+		case table_reduction::mask:
+			return walk_partitioned<table_reduction::mask, TABLE_INDEX>(ctx);
+
+		case table_reduction::multiply:
+			return walk_partitioned<table_reduction::multiply, TABLE_INDEX>(ctx);
+
+		case table_reduction::divide:
+			return walk_partitioned<table_reduction::divide, TABLE_INDEX>(ctx);
+	}
+	return 0;
+}
+
+uint16_t kernel_partitioned(const kernel_context& ctx)
+{
+	if (ctx.wide_indices)
+	{
+		return walk_partitioned<uint64_t>(ctx);
+	}
+	return walk_partitioned<uint32_t>(ctx);
+}
@@ -0,0 +1,109 @@
+#include "kernels.h"
+#include "common.h"
+
+#include <xmmintrin.h>
+
+template<_mm_hint HINT, table_format FORMAT>
+static void prefetch_element(const void* const table, const size_t table_index)
+{
+	_mm_prefetch((const char*)table + get_table_element_offset<FORMAT>(table_index), HINT);
+}
+
+template<_mm_hint HINT, table_format FORMAT, table_reduction REDUCTION, typename TABLE_INDEX>
+static uint16_t walk_with_prefetch(const kernel_context& ctx)
+{
+	uint32_t* const       indices_arr = ctx.indices;
+	const void* const     table = ctx.table;
+	const table_indexing  indexing = ctx.indexing;
+	const uint32_t        thread_id = ctx.thread_id;
+	const uint32_t        distance = ctx.prefetch_distance;
+	uint16_t              value0 = TABLE_XOR_VAL;
+	uint16_t              value1 = TABLE_XOR_VAL;
+	uint16_t              value2 = TABLE_XOR_VAL;
+	uint16_t              value3 = TABLE_XOR_VAL;
+	uint32_t              index = 0;
+
+	// Indices of the first distance entries are not prefetched.
+	const uint32_t prefetched_end = ctx.count_of_indices > distance ? ctx.count_of_indices - distance : 0;
+	for (; index + 4 <= prefetched_end; index += 4)
+	{
+		const uint32_t* const ahead = &indices_arr[index + distance];
+		prefetch_element<HINT, FORMAT>(table, get_table_index<REDUCTION, TABLE_INDEX>((ahead[0] ^ INDEX_XOR_VAL) + thread_id, indexing));
+		prefetch_element<HINT, FORMAT>(table, get_table_index<REDUCTION, TABLE_INDEX>((ahead[1] ^ INDEX_XOR_VAL) + thread_id, indexing));
+		prefetch_element<HINT, FORMAT>(table, get_table_index<REDUCTION, TABLE_INDEX>((ahead[2] ^ INDEX_XOR_VAL) + thread_id, indexing));
+		prefetch_element<HINT, FORMAT>(table, get_table_index<REDUCTION, TABLE_INDEX>((ahead[3] ^ INDEX_XOR_VAL) + thread_id, indexing));
+
+		const uint32_t index0 = (indices_arr[index    ] ^ INDEX_XOR_VAL) + thread_id;
+		const uint32_t index1 = (indices_arr[index + 1] ^ INDEX_XOR_VAL) + thread_id;
+		const uint32_t index2 = (indices_arr[index + 2] ^ INDEX_XOR_VAL) + thread_id;
+		const uint32_t index3 = (indices_arr[index + 3] ^ INDEX_XOR_VAL) + thread_id;
+
+		value0 = (value0 ^ load_table_element<FORMAT>(table, get_table_index<REDUCTION, TABLE_INDEX>(index0, indexing))) & TABLE_ADD_VAL;
+		value1 = (value1 ^ load_table_element<FORMAT>(table, get_table_index<REDUCTION, TABLE_INDEX>(index1, indexing))) & TABLE_ADD_VAL;
+		value2 = (value2 ^ load_table_element<FORMAT>(table, get_table_index<REDUCTION, TABLE_INDEX>(index2, indexing))) & TABLE_ADD_VAL;
+		value3 = (value3 ^ load_table_element<FORMAT>(table, get_table_index<REDUCTION, TABLE_INDEX>(index3, indexing))) & TABLE_ADD_VAL;
+
+		indices_arr[index    ] = index0;
+		indices_arr[index + 1] = index1;
+		indices_arr[index + 2] = index2;
+		indices_arr[index + 3] = index3;
+	}
+
+	return value0 ^ value1 ^ value2 ^ value3 ^ kernel_tail(ctx, index);
+}
+
+template<table_format FORMAT, table_reduction REDUCTION, typename TABLE_INDEX>
+static uint16_t walk_with_prefetch(const kernel_context& ctx)
+{
+	if (ctx.prefetch_locality == prefetch_hint::nta)
+	{
+		return walk_with_prefetch<_MM_HINT_NTA, FORMAT, REDUCTION, TABLE_INDEX>(ctx);
+	}
+	return walk_with_prefetch<_MM_HINT_T0, FORMAT, REDUCTION, TABLE_INDEX>(ctx);
+}
+
+template<table_reduction REDUCTION, typename TABLE_INDEX>
+static uint16_t walk_with_prefetch(const kernel_context& ctx)
+{
+	switch (ctx.format)
+	{
+		case table_format::u8:
+			return walk_with_prefetch<table_format::u8, REDUCTION, TABLE_INDEX>(ctx);
+
+		case table_format::u12:
+			return walk_with_prefetch<table_format::u12, REDUCTION, TABLE_INDEX>(ctx);
+
+		case table_format::u16:
+			return walk_with_prefetch<table_format::u16, REDUCTION, TABLE_INDEX>(ctx);
+
+		case table_format::u32:
+			return walk_with_prefetch<table_format::u32, REDUCTION, TABLE_INDEX>(ctx);
+	}
+	return 0;
+}
+
+template<typename TABLE_INDEX>
+static uint16_t walk_with_prefetch(const kernel_context& ctx)
+{
+	switch (ctx.indexing.reduction)
+	{
+		case table_reduction::mask:
+			return walk_with_prefetch<table_reduction::mask, TABLE_INDEX>(ctx);
+
+		case table_reduction::multiply:
+			return walk_with_prefetch<table_reduction::multiply, TABLE_INDEX>(ctx);
+
+		case table_reduction::divide:
+			return walk_with_prefetch<table_reduction::divide, TABLE_INDEX>(ctx);
+	}
+	return 0;
+}
+
+uint16_t kernel_prefetch(const kernel_context& ctx)
+{
+	if (ctx.wide_indices)
+	{
+		return walk_with_prefetch<uint64_t>(ctx);
+	}
+	return walk_with_prefetch<uint32_t>(ctx);
+}
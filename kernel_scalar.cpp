@@ -0,0 +1,142 @@
+#include "kernels.h"
+#include "common.h"
+
+template<table_format FORMAT, table_reduction REDUCTION, typename TABLE_INDEX>
+static uint16_t walk_scalar(const kernel_context& ctx)
+{
+	uint32_t* const       indices_arr = ctx.indices;
+	const void* const     table = ctx.table;
+	const table_indexing  indexing = ctx.indexing;
+	const uint32_t        thread_id = ctx.thread_id;
+	uint16_t              value0 = TABLE_XOR_VAL;
+	uint16_t              value1 = TABLE_XOR_VAL;
+	uint16_t              value2 = TABLE_XOR_VAL;
+	uint16_t              value3 = TABLE_XOR_VAL;
+	uint32_t              index = 0;
+	for (; index + 4 <= ctx.count_of_indices; index += 4)
+	{
+		const uint32_t index0 = (indices_arr[index    ] ^ INDEX_XOR_VAL) + thread_id;
+		const uint32_t index1 = (indices_arr[index + 1] ^ INDEX_XOR_VAL) + thread_id;
+		const uint32_t index2 = (indices_arr[index + 2] ^ INDEX_XOR_VAL) + thread_id;
+		const uint32_t index3 = (indices_arr[index + 3] ^ INDEX_XOR_VAL) + thread_id;
+
+		value0 = (value0 ^ load_table_element<FORMAT>(table, get_table_index<REDUCTION, TABLE_INDEX>(index0, indexing))) & TABLE_ADD_VAL;
+		value1 = (value1 ^ load_table_element<FORMAT>(table, get_table_index<REDUCTION, TABLE_INDEX>(index1, indexing))) & TABLE_ADD_VAL;
+		value2 = (value2 ^ load_table_element<FORMAT>(table, get_table_index<REDUCTION, TABLE_INDEX>(index2, indexing))) & TABLE_ADD_VAL;
+		value3 = (value3 ^ load_table_element<FORMAT>(table, get_table_index<REDUCTION, TABLE_INDEX>(index3, indexing))) & TABLE_ADD_VAL;
+
+		indices_arr[index    ] = index0;
+		indices_arr[index + 1] = index1;
+		indices_arr[index + 2] = index2;
+		indices_arr[index + 3] = index3;
+	}
+
+	return value0 ^ value1 ^ value2 ^ value3 ^ kernel_tail(ctx, index);
+}
+
+template<table_reduction REDUCTION, typename TABLE_INDEX>
+static uint16_t walk_scalar(const kernel_context& ctx)
+{
+	switch (ctx.format)
+	{
+		case table_format::u8:
+			return walk_scalar<table_format::u8, REDUCTION, TABLE_INDEX>(ctx);
+
+		case table_format::u12:
+			return walk_scalar<table_format::u12, REDUCTION, TABLE_INDEX>(ctx);
+
+		case table_format::u16:
+			return walk_scalar<table_format::u16, REDUCTION, TABLE_INDEX>(ctx);
+
+		case table_format::u32:
+			return walk_scalar<table_format::u32, REDUCTION, TABLE_INDEX>(ctx);
+	}
+	return 0;
+}
+
+template<typename TABLE_INDEX>
+static uint16_t walk_scalar(const kernel_context& ctx)
+{
+	switch (ctx.indexing.reduction)
+	{
+		case table_reduction::mask:
+			return walk_scalar<table_reduction::mask, TABLE_INDEX>(ctx);
+
+		case table_reduction::multiply:
+			return walk_scalar<table_reduction::multiply, TABLE_INDEX>(ctx);
+
+		case table_reduction::divide:
+			return walk_scalar<table_reduction::divide, TABLE_INDEX>(ctx);
+	}
+	return 0;
+}
+
+template<table_format FORMAT, table_reduction REDUCTION, typename TABLE_INDEX>
+static uint16_t walk_tail(const kernel_context& ctx, uint32_t index)
+{
+	const table_indexing indexing = ctx.indexing;
+	uint16_t             value = 0;
+	for (; index < ctx.count_of_indices; ++index)
+	{
+		const uint32_t table_index = (ctx.indices[index] ^ INDEX_XOR_VAL) + ctx.thread_id;
+		value = (value ^ load_table_element<FORMAT>(ctx.table, get_table_index<REDUCTION, TABLE_INDEX>(table_index, indexing))) & TABLE_ADD_VAL;
+		ctx.indices[index] = table_index;
+	}
+
+	return value;
+}
+
+template<table_reduction REDUCTION, typename TABLE_INDEX>
+static uint16_t walk_tail(const kernel_context& ctx, uint32_t index)
+{
+	switch (ctx.format)
+	{
+		case table_format::u8:
+			return walk_tail<table_format::u8, REDUCTION, TABLE_INDEX>(ctx, index);
+
+		case table_format::u12:
+			return walk_tail<table_format::u12, REDUCTION, TABLE_INDEX>(ctx, index);
+
+		case table_format::u16:
+			return walk_tail<table_format::u16, REDUCTION, TABLE_INDEX>(ctx, index);
+
+		case table_format::u32:
+			return walk_tail<table_format::u32, REDUCTION, TABLE_INDEX>(ctx, index);
+	}
+	return 0;
+}
+
+template<typename TABLE_INDEX>
+static uint16_t walk_tail(const kernel_context& ctx, uint32_t index)
+{
+	switch (ctx.indexing.reduction)
+	{
+		case table_reduction::mask:
+			return walk_tail<table_reduction::mask, TABLE_INDEX>(ctx, index);
+
+		case table_reduction::multiply:
+			return walk_tail<table_reduction::multiply, TABLE_INDEX>(ctx, index);
+
+		case table_reduction::divide:
+			return walk_tail<table_reduction::divide, TABLE_INDEX>(ctx, index);
+	}
+	return 0;
+}
+
+uint16_t kernel_scalar(const kernel_context& ctx)
+{
+	if (ctx.wide_indices)
+	{
+		return walk_scalar<uint64_t>(ctx);
+	}
+	return walk_scalar<uint32_t>(ctx);
+}
+
+uint16_t kernel_tail(const kernel_context& ctx, uint32_t index)
+{
+	if (ctx.wide_indices)
+	{
+		return walk_tail<uint64_t>(ctx, index);
+	}
+	return walk_tail<uint32_t>(ctx, index);
+}
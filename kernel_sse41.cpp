@@ -0,0 +1,84 @@
+#include "kernels.h"
+#include "common.h"
+
+#include <smmintrin.h>
+
+template<table_format FORMAT, table_reduction REDUCTION, typename TABLE_INDEX>
+static uint16_t walk_sse41(const kernel_context& ctx)
+{
+	uint32_t* const       indices_arr = ctx.indices;
+	const void* const     table = ctx.table;
+	const table_indexing  indexing = ctx.indexing;
+	const uint32_t        thread_id = ctx.thread_id;
+	uint16_t              value0 = TABLE_XOR_VAL;
+	uint16_t              value1 = TABLE_XOR_VAL;
+	uint16_t              value2 = TABLE_XOR_VAL;
+	uint16_t              value3 = TABLE_XOR_VAL;
+	uint32_t              index = 0;
+	for (; index + 4 <= ctx.count_of_indices; index += 4)
+	{
+		__m128i indices = _mm_set_epi32(
+				(indices_arr[index    ] ^ INDEX_XOR_VAL) + thread_id,
+				(indices_arr[index + 1] ^ INDEX_XOR_VAL) + thread_id,
+				(indices_arr[index + 2] ^ INDEX_XOR_VAL) + thread_id,
+				(indices_arr[index + 3] ^ INDEX_XOR_VAL) + thread_id);
+
+		value0 = (value0 ^ load_table_element<FORMAT>(table, get_table_index<REDUCTION, TABLE_INDEX>((uint32_t)_mm_extract_epi32(indices, 0), indexing))) & TABLE_ADD_VAL;
+		value1 = (value1 ^ load_table_element<FORMAT>(table, get_table_index<REDUCTION, TABLE_INDEX>((uint32_t)_mm_extract_epi32(indices, 1), indexing))) & TABLE_ADD_VAL;
+		value2 = (value2 ^ load_table_element<FORMAT>(table, get_table_index<REDUCTION, TABLE_INDEX>((uint32_t)_mm_extract_epi32(indices, 2), indexing))) & TABLE_ADD_VAL;
+		value3 = (value3 ^ load_table_element<FORMAT>(table, get_table_index<REDUCTION, TABLE_INDEX>((uint32_t)_mm_extract_epi32(indices, 3), indexing))) & TABLE_ADD_VAL;
+
+		indices_arr[index    ] = _mm_extract_epi32(indices, 0);
+		indices_arr[index + 1] = _mm_extract_epi32(indices, 1);
+		indices_arr[index + 2] = _mm_extract_epi32(indices, 2);
+		indices_arr[index + 3] = _mm_extract_epi32(indices, 3);
+	}
+
+	return value0 ^ value1 ^ value2 ^ value3 ^ kernel_tail(ctx, index);
+}
+
+template<table_reduction REDUCTION, typename TABLE_INDEX>
+static uint16_t walk_sse41(const kernel_context& ctx)
+{
+	switch (ctx.format)
+	{
+		case table_format::u8:
+			return walk_sse41<table_format::u8, REDUCTION, TABLE_INDEX>(ctx);
+
+		case table_format::u12:
+			return walk_sse41<table_format::u12, REDUCTION, TABLE_INDEX>(ctx);
+
+		case table_format::u16:
+			return walk_sse41<table_format::u16, REDUCTION, TABLE_INDEX>(ctx);
+
+		case table_format::u32:
+			return walk_sse41<table_format::u32, REDUCTION, TABLE_INDEX>(ctx);
+	}
+	return 0;
+}
+
+template<typename TABLE_INDEX>
+static uint16_t walk_sse41(const kernel_context& ctx)
+{
+	switch (ctx.indexing.reduction)
+	{
+		case table_reduction::mask:
+			return walk_sse41<table_reduction::mask, TABLE_INDEX>(ctx);
+
+		case table_reduction::multiply:
+			return walk_sse41<table_reduction::multiply, TABLE_INDEX>(ctx);
+
+		case table_reduction::divide:
+			return walk_sse41<table_reduction::divide, TABLE_INDEX>(ctx);
+	}
+	return 0;
+}
+
+uint16_t kernel_sse41(const kernel_context& ctx)
+{
+	if (ctx.wide_indices)
+	{
+		return walk_sse41<uint64_t>(ctx);
+	}
+	return walk_sse41<uint32_t>(ctx);
+}
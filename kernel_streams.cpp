@@ -0,0 +1,113 @@
+#include "kernels.h"
+#include "common.h"
+
+/** Walks the indices as STREAMS interleaved streams.
+ *
+ * Address of each table access depends on the value loaded by the previous
+ * access of the same stream, so at most STREAMS misses are outstanding. The
+ * dependency is made by a zero hidden from the compiler, so the accessed
+ * entries and the returned value are the same as with the other kernels.
+ */
+template<uint32_t STREAMS, table_format FORMAT, table_reduction REDUCTION, typename TABLE_INDEX>
+static uint16_t walk_streams(const kernel_context& ctx)
+{
+	uint32_t* const       indices_arr = ctx.indices;
+	const void* const     table = ctx.table;
+	const table_indexing  indexing = ctx.indexing;
+	const uint32_t        thread_id = ctx.thread_id;
+	// Accumulators start at 0, since an odd count of them would not cancel TABLE_XOR_VAL.
+	uint32_t              values[STREAMS] = {};
+	uint32_t              index = 0;
+	uint32_t              dependency = 0;
+	__asm__("" : "+r"(dependency));
+
+	for (; index + STREAMS <= ctx.count_of_indices; index += STREAMS)
+	{
+		for (uint32_t stream = 0; stream < STREAMS; ++stream)
+		{
+			const uint32_t table_index = (indices_arr[index + stream] ^ INDEX_XOR_VAL) + thread_id;
+			values[stream] = (values[stream] ^ load_table_element<FORMAT>(table, get_table_index<REDUCTION, TABLE_INDEX>(table_index ^ (values[stream] & dependency), indexing))) & TABLE_ADD_VAL;
+			indices_arr[index + stream] = table_index;
+		}
+	}
+
+	uint16_t value = 0;
+	for (uint32_t stream = 0; stream < STREAMS; ++stream)
+	{
+		value ^= values[stream];
+	}
+
+	return value ^ kernel_tail(ctx, index);
+}
+
+template<table_format FORMAT, table_reduction REDUCTION, typename TABLE_INDEX>
+static uint16_t walk_streams(const kernel_context& ctx)
+{
+	switch (ctx.stream_count)
+	{
+		case 1:
+			return walk_streams<1, FORMAT, REDUCTION, TABLE_INDEX>(ctx);
+
+		case 2:
+			return walk_streams<2, FORMAT, REDUCTION, TABLE_INDEX>(ctx);
+
+		case 4:
+			return walk_streams<4, FORMAT, REDUCTION, TABLE_INDEX>(ctx);
+
+		case 8:
+			return walk_streams<8, FORMAT, REDUCTION, TABLE_INDEX>(ctx);
+
+		case 16:
+			return walk_streams<16, FORMAT, REDUCTION, TABLE_INDEX>(ctx);
+
+		case 32:
+			return walk_streams<32, FORMAT, REDUCTION, TABLE_INDEX>(ctx);
+	}
+	return 0;
+}
+
+template<table_reduction REDUCTION, typename TABLE_INDEX>
+static uint16_t walk_streams(const kernel_context& ctx)
+{
+	switch (ctx.format)
+	{
+		case table_format::u8:
+			return walk_streams<table_format::u8, REDUCTION, TABLE_INDEX>(ctx);
+
+		case table_format::u12:
+			return walk_streams<table_format::u12, REDUCTION, TABLE_INDEX>(ctx);
+
+		case table_format::u16:
+			return walk_streams<table_format::u16, REDUCTION, TABLE_INDEX>(ctx);
+
+		case table_format::u32:
+			return walk_streams<table_format::u32, REDUCTION, TABLE_INDEX>(ctx);
+	}
+	return 0;
+}
+
+template<typename TABLE_INDEX>
+static uint16_t walk_streams(const kernel_context& ctx)
+{
+	switch (ctx.indexing.reduction)
+	{
+		case table_reduction::mask:
+			return walk_streams<table_reduction::mask, TABLE_INDEX>(ctx);
+
+		case table_reduction::multiply:
+			return walk_streams<table_reduction::multiply, TABLE_INDEX>(ctx);
+
+		case table_reduction::divide:
+			return walk_streams<table_reduction::divide, TABLE_INDEX>(ctx);
+	}
+	return 0;
+}
+
+uint16_t kernel_streams(const kernel_context& ctx)
+{
+	if (ctx.wide_indices)
+	{
+		return walk_streams<uint64_t>(ctx);
+	}
+	return walk_streams<uint32_t>(ctx);
+}
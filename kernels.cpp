@@ -0,0 +1,53 @@
+#include "kernels.h"
+#include "cpu_features.h"
+
+#include <string.h>
+
+static const kernel_desc KERNELS[] =
+{
+	{ "scalar",      0,                                                         kernel_scalar,      0 },
+	{ "sse41",       CPU_FEATURE_SSE41,                                         kernel_sse41,       0 },
+	{ "avx2",        CPU_FEATURE_AVX2 | CPU_FEATURE_BMI2,                       kernel_avx2,        0 },
+	{ "avx512",      CPU_FEATURE_AVX512F | CPU_FEATURE_AVX2 | CPU_FEATURE_BMI2, kernel_avx512,      0 },
+	{ "prefetch",    0,                                                         kernel_prefetch,    KERNEL_FLAG_PREFETCH },
+	{ "streams",     0,                                                         kernel_streams,     KERNEL_FLAG_STREAMS },
+	{ "chain",       0,                                                         kernel_chain,       KERNEL_FLAG_STREAMS | KERNEL_FLAG_CHAIN },
+	{ "partitioned", 0,                                                         kernel_partitioned, KERNEL_FLAG_PARTITION },
+	{ "latency",     0,                                                         kernel_latency,     KERNEL_FLAG_LATENCY },
+};
+
+bool needs_wide_indices(table_format format, uint64_t count_of_elements)
+{
+	return get_table_size(format, count_of_elements) > ((uint64_t)1 << 31);
+}
+
+const kernel_desc* get_kernels(uint32_t& count)
+{
+	count = sizeof(KERNELS) / sizeof(KERNELS[0]);
+	return KERNELS;
+}
+
+const kernel_desc* find_kernel(const char* name)
+{
+	for (const kernel_desc& desc : KERNELS)
+	{
+		if (strcmp(desc.name, name) == 0)
+		{
+			return &desc;
+		}
+	}
+	return nullptr;
+}
+
+const kernel_desc* select_kernel(uint32_t cpu_features)
+{
+	const kernel_desc* selected = nullptr;
+	for (const kernel_desc& desc : KERNELS)
+	{
+		if (!desc.flags && (desc.required_features & cpu_features) == desc.required_features)
+		{
+			selected = &desc;
+		}
+	}
+	return selected;
+}
@@ -0,0 +1,180 @@
+#ifndef _KERNELS_H_
+#define _KERNELS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "table_format.h"
+#include "table_index.h"
+
+class latency_histogram;
+
+/** Table access kernels.
+ *
+ * Every kernel lives in its own translation unit compiled with the -m flags of
+ * its instruction set (see Makefile), so the kernel translation units must not
+ * define inline functions or instantiate templates shared with other
+ * translation units - the linker could pick the copy which uses instructions
+ * not supported by the CPU.
+ *
+ * Kernels are templates over the table format, the reduction of the indices to
+ * the table and the type of table indices, every kernel function dispatches to
+ * the instance of kernel_context::format, kernel_context::indexing and
+ * kernel_context::wide_indices.
+ *
+ * All kernels do one pass over the indices and return XOR of their
+ * accumulators. Since (a ^ b) & TABLE_ADD_VAL == (a & TABLE_ADD_VAL) ^
+ * (b & TABLE_ADD_VAL) and every kernel uses an even count of accumulators, the
+ * returned value does not depend on the kernel.
+ */
+
+/// Locality hint of software prefetches.
+enum class prefetch_hint : uint32_t
+{
+	t0,
+	nta,
+};
+
+struct kernel_context
+{
+	uint32_t*       indices;
+
+	const void*     table;
+
+	table_format    format;
+
+	uint32_t        count_of_indices;
+
+	/// Reduction of the indices to the table, see get_table_index().
+	table_indexing  indexing;
+
+	/// Whether the table needs 64-bit indices, see needs_wide_indices().
+	bool            wide_indices;
+
+	uint32_t        thread_id;
+
+	/// Count of indices the table entries are prefetched ahead, 0 disables the prefetch.
+	uint32_t        prefetch_distance;
+
+	prefetch_hint   prefetch_locality;
+
+	/// Count of interleaved dependent streams, one of KERNEL_STREAM_COUNTS.
+	uint32_t        stream_count;
+
+	/// Count of input symbols of the DFA, a power of two.
+	uint32_t        alphabet_size;
+
+	/// Count of high bits of the table index the indices are partitioned by.
+	uint32_t        partition_bits;
+
+	/// Count of indices partitioned at once.
+	uint32_t        batch_size;
+
+	/// Per-thread memory of get_partition_scratch_count() elements.
+	uint32_t*       scratch;
+
+	/// Every latency_interval-th lookup is timed.
+	uint32_t        latency_interval;
+
+	/// Per-thread histogram of the timed lookups.
+	latency_histogram* histogram;
+};
+
+/// Stream counts the streams kernel is generated for.
+constexpr uint32_t KERNEL_STREAM_COUNTS[] = { 1, 2, 4, 8, 16, 32 };
+
+// Default parameters of the specialized kernels.
+constexpr uint32_t PREFETCH_DISTANCE_DEFAULT = 16;
+constexpr uint32_t STREAM_COUNT_DEFAULT      = 4;
+constexpr uint32_t ALPHABET_SIZE_DEFAULT     = 256;
+constexpr uint32_t BATCH_SIZE_DEFAULT        = 64 * 1024;
+constexpr uint32_t LATENCY_INTERVAL_DEFAULT  = 64;
+constexpr uint32_t PARTITION_BITS_MAX        = 16;
+// Largest region of the table covered by a bucket of get_partition_bits().
+constexpr size_t   PARTITION_REGION_SIZE     = 256 * 1024;
+
+// Gather kernels load 32-bit lanes at 16-bit element offsets, so the load of the last
+// table element reads past the end of the table.
+constexpr uint32_t TABLE_BUFFER_PADDING      = 64;
+
+typedef uint16_t (*kernel_func)(const kernel_context& ctx);
+
+/// Properties of kernels.
+enum kernel_flag : uint32_t
+{
+	/// Kernel uses prefetch_distance and prefetch_hint.
+	KERNEL_FLAG_PREFETCH  = 1 << 0,
+	/// Kernel uses stream_count.
+	KERNEL_FLAG_STREAMS   = 1 << 1,
+	/// Kernel walks the table as a DFA, uses alphabet_size.
+	KERNEL_FLAG_CHAIN     = 1 << 2,
+	/// Kernel partitions the indices, uses partition_bits, batch_size and scratch.
+	KERNEL_FLAG_PARTITION = 1 << 3,
+	/// Kernel times lookups, uses latency_interval and histogram.
+	KERNEL_FLAG_LATENCY   = 1 << 4,
+};
+
+struct kernel_desc
+{
+	const char* name;
+
+	/// Mask of cpu_feature values the kernel needs.
+	uint32_t    required_features;
+
+	kernel_func func;
+
+	/// Mask of kernel_flag values.
+	uint32_t    flags;
+};
+
+uint16_t kernel_scalar(const kernel_context& ctx);
+
+uint16_t kernel_sse41(const kernel_context& ctx);
+
+uint16_t kernel_avx2(const kernel_context& ctx);
+
+uint16_t kernel_avx512(const kernel_context& ctx);
+
+uint16_t kernel_prefetch(const kernel_context& ctx);
+
+uint16_t kernel_streams(const kernel_context& ctx);
+
+uint16_t kernel_chain(const kernel_context& ctx);
+
+uint16_t kernel_partitioned(const kernel_context& ctx);
+
+uint16_t kernel_latency(const kernel_context& ctx);
+
+/// Count of uint32_t elements of the scratch memory of kernel_partitioned().
+size_t get_partition_scratch_count(uint32_t batch_size, uint32_t partition_bits);
+
+/// Partition bits which keep a bucket within PARTITION_REGION_SIZE of the table.
+uint32_t get_partition_bits(size_t table_size);
+
+/// Handles indices from @p index to the end which do not fill a whole vector.
+uint16_t kernel_tail(const kernel_context& ctx, uint32_t index);
+
+/** Returns whether the kernels need 64-bit table indices for a table.
+ *
+ * Gathers take signed 32-bit byte offsets, so 32-bit indices serve tables of
+ * up to 2 GiB.
+ */
+bool needs_wide_indices(table_format format, uint64_t count_of_elements);
+
+/** Returns all kernels ordered from the least to the most preferred one, kernels
+ * with flags are at the end.
+ *
+ * @param count Output for the count of kernels.
+ */
+const kernel_desc* get_kernels(uint32_t& count);
+
+/// Returns kernel with given name or nullptr.
+const kernel_desc* find_kernel(const char* name);
+
+/** Returns the most preferred kernel supported by the CPU with given features.
+ *
+ * Only kernels without flags are considered, the others need parameters.
+ */
+const kernel_desc* select_kernel(uint32_t cpu_features);
+
+#endif /* end of include guard: _KERNELS_H_ */
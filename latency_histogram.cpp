@@ -0,0 +1,74 @@
+#include "latency_histogram.h"
+
+#include <algorithm>
+#include <string.h>
+
+static uint32_t get_bucket(const uint64_t value)
+{
+	if (value < 2 * LATENCY_SUB_BUCKET_COUNT)
+	{
+		return (uint32_t)value;
+	}
+	// Top LATENCY_SUB_BUCKET_BITS + 1 bits of the value, the highest one is always set.
+	const uint32_t shift = 63 - __builtin_clzll(value) - LATENCY_SUB_BUCKET_BITS;
+	return shift * LATENCY_SUB_BUCKET_COUNT + (uint32_t)(value >> shift);
+}
+
+/// Highest value which falls to @p bucket.
+static uint64_t get_bucket_max(const uint32_t bucket)
+{
+	if (bucket < 2 * LATENCY_SUB_BUCKET_COUNT)
+	{
+		return bucket;
+	}
+	const uint32_t shift = bucket / LATENCY_SUB_BUCKET_COUNT - 1;
+	const uint64_t top = bucket % LATENCY_SUB_BUCKET_COUNT + LATENCY_SUB_BUCKET_COUNT;
+	return ((top + 1) << shift) - 1;
+}
+
+void latency_histogram::record(const uint64_t value)
+{
+	counts[get_bucket(value)]++;
+	count++;
+	min = std::min(min, value);
+	max = std::max(max, value);
+}
+
+void latency_histogram::merge(const latency_histogram& rhs)
+{
+	for (uint32_t bucket = 0; bucket < LATENCY_BUCKET_COUNT; ++bucket)
+	{
+		counts[bucket] += rhs.counts[bucket];
+	}
+	count += rhs.count;
+	min = std::min(min, rhs.min);
+	max = std::max(max, rhs.max);
+}
+
+void latency_histogram::reset()
+{
+	memset(counts, 0, sizeof(counts));
+	count = 0;
+	min = UINT64_MAX;
+	max = 0;
+}
+
+uint64_t latency_histogram::get_percentile(const double percentile) const
+{
+	if (!count)
+	{
+		return 0;
+	}
+	// Count of values at or below the percentile, at least one.
+	const uint64_t rank = std::max<uint64_t>((uint64_t)(percentile / 100.0 * count + 0.5), 1);
+	uint64_t       below = 0;
+	for (uint32_t bucket = 0; bucket < LATENCY_BUCKET_COUNT; ++bucket)
+	{
+		below += counts[bucket];
+		if (below >= rank)
+		{
+			return std::min(get_bucket_max(bucket), max);
+		}
+	}
+	return max;
+}
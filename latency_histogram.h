@@ -0,0 +1,59 @@
+#ifndef _LATENCY_HISTOGRAM_H_
+#define _LATENCY_HISTOGRAM_H_
+
+#include <stdint.h>
+
+// Values below 2 * LATENCY_SUB_BUCKET_COUNT have their own buckets, each higher
+// power of two range has LATENCY_SUB_BUCKET_COUNT buckets.
+constexpr uint32_t LATENCY_SUB_BUCKET_BITS  = 4;
+constexpr uint32_t LATENCY_SUB_BUCKET_COUNT = 1u << LATENCY_SUB_BUCKET_BITS;
+constexpr uint32_t LATENCY_BUCKET_COUNT     = (64 - LATENCY_SUB_BUCKET_BITS + 1) * LATENCY_SUB_BUCKET_COUNT;
+
+/** Histogram of latencies with logarithmic buckets, as in HdrHistogram.
+ *
+ * Each power of two range is split to LATENCY_SUB_BUCKET_COUNT linear
+ * buckets, so the relative error of a recorded value is at most
+ * 1 / LATENCY_SUB_BUCKET_COUNT for any magnitude of the values.
+ */
+class latency_histogram
+{
+public:
+	void record(uint64_t value);
+
+	/// Adds counts of @p rhs, histograms of the threads are merged this way.
+	void merge(const latency_histogram& rhs);
+
+	void reset();
+
+	uint64_t get_count() const
+	{
+		return count;
+	}
+
+	uint64_t get_min() const
+	{
+		return count ? min : 0;
+	}
+
+	uint64_t get_max() const
+	{
+		return max;
+	}
+
+	/** Returns the highest value equivalent to the value at @p percentile.
+	 *
+	 * @param percentile Percentile from 0 to 100.
+	 */
+	uint64_t get_percentile(double percentile) const;
+
+private:
+	uint64_t counts[LATENCY_BUCKET_COUNT] = {};
+
+	uint64_t count = 0;
+
+	uint64_t min = UINT64_MAX;
+
+	uint64_t max = 0;
+};
+
+#endif /* end of include guard: _LATENCY_HISTOGRAM_H_ */
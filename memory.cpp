@@ -0,0 +1,186 @@
+#include "memory.h"
+#include "common.h"
+#include "scope_guard.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <stdio.h>
+
+constexpr size_t PAGE_SIZE_2M   = 2 * 1024 * 1024;
+constexpr size_t PAGE_SIZE_1G   = 1024 * 1024 * 1024;
+constexpr int    MAP_HUGE_2M    = 21 << MAP_HUGE_SHIFT;
+constexpr int    MAP_HUGE_1G    = 30 << MAP_HUGE_SHIFT;
+
+static size_t round_up(size_t value, size_t alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+static void* allocate_hugetlb(size_t size, size_t page_size, int page_flag, size_t& mapped_size)
+{
+	const size_t length = round_up(size, page_size);
+	void* const  data = mmap(
+			nullptr,
+			length,
+			PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | page_flag,
+			-1,
+			0);
+	if (data == MAP_FAILED)
+	{
+		return nullptr;
+	}
+	mapped_size = length;
+	return data;
+}
+
+static void* allocate_thp(size_t size, size_t& mapped_size)
+{
+	// Transparent huge pages are used only for 2 MiB aligned ranges, so the
+	// mapping is over-allocated and trimmed to the alignment.
+	const size_t length = round_up(size, PAGE_SIZE_2M);
+	uint8_t* const reserved = (uint8_t*)mmap(
+			nullptr,
+			length + PAGE_SIZE_2M,
+			PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS,
+			-1,
+			0);
+	if (reserved == MAP_FAILED)
+	{
+		return nullptr;
+	}
+	uint8_t* const data = (uint8_t*)round_up((uintptr_t)reserved, PAGE_SIZE_2M);
+	if (data != reserved)
+	{
+		munmap(reserved, data - reserved);
+	}
+	munmap(data + length, reserved + PAGE_SIZE_2M - data);
+
+	if (madvise(data, length, MADV_HUGEPAGE) < 0)
+	{
+		INFO("madvise(MADV_HUGEPAGE) failed\n");
+	}
+	mapped_size = length;
+	return data;
+}
+
+static void* allocate_normal(size_t size, size_t& mapped_size)
+{
+	const size_t length = round_up(size, sysconf(_SC_PAGESIZE));
+	void* const  data = mmap(
+			nullptr,
+			length,
+			PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS,
+			-1,
+			0);
+	if (data == MAP_FAILED)
+	{
+		return nullptr;
+	}
+	// With THP enabled "always" the kernel would back the mapping by huge pages anyway.
+	if (madvise(data, length, MADV_NOHUGEPAGE) < 0)
+	{
+		INFO("madvise(MADV_NOHUGEPAGE) failed\n");
+	}
+	mapped_size = length;
+	return data;
+}
+
+void* allocate_pages(size_t size, page_mode mode, page_mode& obtained, size_t& mapped_size)
+{
+	void* data = nullptr;
+	switch (mode)
+	{
+		case page_mode::huge_1g:
+			data = allocate_hugetlb(size, PAGE_SIZE_1G, MAP_HUGE_1G, mapped_size);
+			if (data)
+			{
+				obtained = page_mode::huge_1g;
+				return data;
+			}
+			INFO("no 1 GiB huge pages available for %zu bytes\n", size);
+			// fall through
+
+		case page_mode::huge_2m:
+			data = allocate_hugetlb(size, PAGE_SIZE_2M, MAP_HUGE_2M, mapped_size);
+			if (data)
+			{
+				obtained = page_mode::huge_2m;
+				return data;
+			}
+			INFO("no 2 MiB huge pages available for %zu bytes\n", size);
+			// fall through
+
+		case page_mode::thp:
+			obtained = page_mode::thp;
+			return allocate_thp(size, mapped_size);
+
+		case page_mode::normal:
+			obtained = page_mode::normal;
+			return allocate_normal(size, mapped_size);
+	}
+
+	return nullptr;
+}
+
+size_t get_page_size(page_mode mode)
+{
+	switch (mode)
+	{
+		case page_mode::huge_1g:
+			return PAGE_SIZE_1G;
+
+		case page_mode::huge_2m:
+		case page_mode::thp:
+			return PAGE_SIZE_2M;
+
+		case page_mode::normal:
+			break;
+	}
+	return sysconf(_SC_PAGESIZE);
+}
+
+int query_page_backing(const void* address, size_t& kernel_page_size, size_t& anon_huge_size)
+{
+	FILE* const smaps = fopen("/proc/self/smaps", "r");
+	if (!smaps)
+	{
+		return -1;
+	}
+	auto close_smaps = scope_exit([&]() { fclose(smaps); });
+
+	char line[512];
+	bool in_mapping = false;
+	bool found_page_size = false;
+	bool found_anon_huge = false;
+	while (fgets(line, sizeof(line), smaps))
+	{
+		uintptr_t start;
+		uintptr_t end;
+		size_t    value;
+		// Lines starting a new mapping look like "7f0000000000-7f0000200000 rw-p ...".
+		if (sscanf(line, "%" SCNxPTR "-%" SCNxPTR " ", &start, &end) == 2)
+		{
+			if (in_mapping)
+			{
+				break;
+			}
+			in_mapping = (uintptr_t)address >= start && (uintptr_t)address < end;
+		}
+		else if (in_mapping && sscanf(line, "KernelPageSize: %zu kB", &value) == 1)
+		{
+			kernel_page_size = value * 1024;
+			found_page_size = true;
+		}
+		else if (in_mapping && sscanf(line, "AnonHugePages: %zu kB", &value) == 1)
+		{
+			anon_huge_size = value * 1024;
+			found_anon_huge = true;
+		}
+	}
+
+	return found_page_size && found_anon_huge ? 0 : -1;
+}
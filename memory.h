@@ -0,0 +1,47 @@
+#ifndef _MEMORY_H_
+#define _MEMORY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// Size of pages backing an allocation.
+enum class page_mode : uint32_t
+{
+	/// Base pages, transparent huge pages are disabled by madvise(MADV_NOHUGEPAGE).
+	normal,
+	/// Transparent huge pages requested by madvise(MADV_HUGEPAGE).
+	thp,
+	/// 2 MiB pages from the hugetlb pool, falls back to thp.
+	huge_2m,
+	/// 1 GiB pages from the hugetlb pool, falls back to huge_2m.
+	huge_1g,
+};
+
+/** Allocates anonymous private memory backed by pages of given size.
+ *
+ * The memory is read-write and not populated.
+ *
+ * @param size        Count of bytes to allocate.
+ * @param mode        Requested page size.
+ * @param obtained    Output for the mode actually used after fallbacks.
+ * @param mapped_size Output for the length of the mapping, which has to be
+ *                    passed to munmap().
+ *
+ * @return Address of the memory or nullptr on failure.
+ */
+void* allocate_pages(size_t size, page_mode mode, page_mode& obtained, size_t& mapped_size);
+
+/// Returns size of the pages requested by @p mode.
+size_t get_page_size(page_mode mode);
+
+/** Reads page backing of the mapping containing @p address from /proc/self/smaps.
+ *
+ * @param address          Address within the mapping.
+ * @param kernel_page_size Output for the page size the kernel uses for the mapping.
+ * @param anon_huge_size   Output for the count of bytes backed by transparent huge pages.
+ *
+ * @return 0 on success, -1 on failure.
+ */
+int query_page_backing(const void* address, size_t& kernel_page_size, size_t& anon_huge_size);
+
+#endif /* end of include guard: _MEMORY_H_ */
@@ -0,0 +1,59 @@
+#ifndef _NAMED_VALUE_H_
+#define _NAMED_VALUE_H_
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+/// Entry of a table which maps names used on the command line to enum values.
+template<typename T>
+struct named_value
+{
+	const char* name;
+
+	T           value;
+};
+
+/** Looks up value by name.
+ *
+ * @return 0 on success, -1 if the name is not in the table.
+ */
+template<typename T, size_t N>
+int parse_named_value(const named_value<T> (&values)[N], const char* name, T& value)
+{
+	for (const named_value<T>& entry : values)
+	{
+		if (strcmp(entry.name, name) == 0)
+		{
+			value = entry.value;
+			return 0;
+		}
+	}
+	return -1;
+}
+
+/// Looks up name of the value, returns "unknown" if it is not in the table.
+template<typename T, size_t N>
+const char* get_value_name(const named_value<T> (&values)[N], T value)
+{
+	for (const named_value<T>& entry : values)
+	{
+		if (entry.value == value)
+		{
+			return entry.name;
+		}
+	}
+	return "unknown";
+}
+
+/// Prints names of all values separated by spaces.
+template<typename T, size_t N>
+void print_value_names(FILE* file, const named_value<T> (&values)[N])
+{
+	for (const named_value<T>& entry : values)
+	{
+		fprintf(file, " %s", entry.name);
+	}
+}
+
+#endif /* end of include guard: _NAMED_VALUE_H_ */
@@ -0,0 +1,206 @@
+#include "numa_placement.h"
+#include "common.h"
+#include "scope_guard.h"
+
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <errno.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <utility>
+
+// Kernel ignores the last bit of the node mask, see get_nodes() in mm/mempolicy.c.
+constexpr unsigned long NODE_MASK_BITS = NUMA_NODES_MAX + 1;
+
+static int parse_list(const char* const path, bool* const items, const uint32_t items_max)
+{
+	FILE* const file = fopen(path, "r");
+	if (!file)
+	{
+		return -1;
+	}
+	auto close_file = scope_exit([&]() { fclose(file); });
+
+	// Lists look like "0-3,8-11,16".
+	char line[4096];
+	if (!fgets(line, sizeof(line), file))
+	{
+		return -1;
+	}
+	const char* str = line;
+	while (*str >= '0' && *str <= '9')
+	{
+		char*          end = nullptr;
+		const uint32_t first = (uint32_t)strtoul(str, &end, 10);
+		uint32_t       last = first;
+		if (*end == '-')
+		{
+			last = (uint32_t)strtoul(end + 1, &end, 10);
+		}
+		for (uint32_t item = first; item <= last && item < items_max; ++item)
+		{
+			items[item] = true;
+		}
+		str = (*end == ',') ? end + 1 : end;
+	}
+
+	return 0;
+}
+
+int detect_numa_topology(numa_topology& topology)
+{
+	topology = numa_topology();
+
+	bool online[NUMA_NODES_MAX] = {};
+	if (parse_list("/sys/devices/system/node/online", online, NUMA_NODES_MAX) < 0)
+	{
+		topology.node_count = 1;
+		return 0;
+	}
+
+	for (uint32_t node = 0; node < NUMA_NODES_MAX; ++node)
+	{
+		if (!online[node])
+		{
+			continue;
+		}
+		topology.nodes[topology.node_count++] = node;
+
+		char path[256];
+		snprintf(path, sizeof(path), "/sys/devices/system/node/node%u/cpulist", node);
+		bool cpus[NUMA_CPUS_MAX] = {};
+		if (parse_list(path, cpus, NUMA_CPUS_MAX) < 0)
+		{
+			ERR("failed to read %s\n", path);
+			return -1;
+		}
+		for (uint32_t cpu = 0; cpu < NUMA_CPUS_MAX; ++cpu)
+		{
+			if (cpus[cpu])
+			{
+				topology.cpu_node[cpu] = node;
+			}
+		}
+	}
+
+	if (topology.node_count == 0)
+	{
+		topology.node_count = 1;
+	}
+	return 0;
+}
+
+static int bind_memory(void* const data, const size_t size, const int policy, const uint64_t node_mask)
+{
+	unsigned long mask = node_mask;
+	if (syscall(SYS_mbind, data, size, policy, &mask, NODE_MASK_BITS, 0) < 0)
+	{
+		ERR("mbind(%s) failed\n", policy == MPOL_BIND ? "MPOL_BIND" : "MPOL_INTERLEAVE");
+		return -1;
+	}
+	return 0;
+}
+
+int allocate_numa_buffer(
+		size_t               size,
+		size_t               padding,
+		page_mode            pages,
+		numa_mode            mode,
+		uint32_t             node,
+		const numa_topology& topology,
+		input_buffer&        buffer)
+{
+	page_mode    obtained;
+	size_t       mapped_size;
+	void* const  data = allocate_pages(size + padding, pages, obtained, mapped_size);
+	if (!data)
+	{
+		ERR("allocation of %zu bytes failed\n", size + padding);
+		return -1;
+	}
+	input_buffer created = input_buffer::from_mapping(data, size, mapped_size);
+
+	// The policy is set before the pages are touched, so it does not matter
+	// which CPU touches them first.
+	if (mode == numa_mode::local)
+	{
+		if (bind_memory(data, mapped_size, MPOL_BIND, 1ull << node) < 0)
+		{
+			return -1;
+		}
+	}
+	else if (mode == numa_mode::interleave)
+	{
+		uint64_t node_mask = 0;
+		for (uint32_t i = 0; i < topology.node_count; ++i)
+		{
+			node_mask |= 1ull << topology.nodes[i];
+		}
+		if (bind_memory(data, mapped_size, MPOL_INTERLEAVE, node_mask) < 0)
+		{
+			return -1;
+		}
+	}
+
+	buffer = std::move(created);
+	return 0;
+}
+
+int create_numa_copy(
+		const input_buffer&  source,
+		size_t               padding,
+		page_mode            pages,
+		numa_mode            mode,
+		uint32_t             node,
+		const numa_topology& topology,
+		input_buffer&        copy)
+{
+	const size_t size = source.get_size();
+	input_buffer created;
+	if (allocate_numa_buffer(size, padding, pages, mode, node, topology, created) < 0)
+	{
+		return -1;
+	}
+
+	memcpy(created.get<void>(), source.get<void>(), size);
+	memset(created.get<char>() + size, 0, padding);
+	copy = std::move(created);
+	return 0;
+}
+
+void* allocate_on_node(size_t size, uint32_t node, size_t& mapped_size)
+{
+	const size_t page_size = sysconf(_SC_PAGESIZE);
+	const size_t length = (size + page_size - 1) / page_size * page_size;
+	void* const  data = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (data == MAP_FAILED)
+	{
+		ERR("mmap of %zu bytes failed\n", length);
+		return nullptr;
+	}
+
+	unsigned long mask = 1ull << node;
+	if (syscall(SYS_mbind, data, length, MPOL_PREFERRED, &mask, NODE_MASK_BITS, 0) < 0 && errno != ENOSYS)
+	{
+		ERR("mbind(MPOL_PREFERRED) failed\n");
+		munmap(data, length);
+		return nullptr;
+	}
+	mapped_size = length;
+	return data;
+}
+
+int get_memory_node(const void* address)
+{
+	const size_t page_size = sysconf(_SC_PAGESIZE);
+	void*        page = (void*)((uintptr_t)address & ~(page_size - 1));
+	int          status = -1;
+	// move_pages() without target nodes only queries the nodes of the pages.
+	if (syscall(SYS_move_pages, 0, 1, &page, nullptr, &status, 0) < 0 || status < 0)
+	{
+		return -1;
+	}
+	return status;
+}
@@ -0,0 +1,107 @@
+#ifndef _NUMA_PLACEMENT_H_
+#define _NUMA_PLACEMENT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "input_buffer.h"
+#include "memory.h"
+
+constexpr uint32_t NUMA_NODES_MAX = 64;
+constexpr uint32_t NUMA_CPUS_MAX  = 1024;
+
+/// Placement of the buffers read by the threads.
+enum class numa_mode : uint32_t
+{
+	/// Buffers stay where they were first touched.
+	none,
+	/// Each node gets its own copy of the buffers, threads use the copy of their node.
+	local,
+	/// One copy of the buffers with pages interleaved over all nodes.
+	interleave,
+};
+
+struct numa_topology
+{
+	/// Count of online nodes.
+	uint32_t node_count = 0;
+
+	/// Ids of the online nodes, ids need not be contiguous.
+	uint32_t nodes[NUMA_NODES_MAX] = {};
+
+	/// Node of each CPU.
+	uint32_t cpu_node[NUMA_CPUS_MAX] = {};
+};
+
+/** Reads NUMA topology from /sys/devices/system/node.
+ *
+ * Systems without NUMA support are reported as a single node 0.
+ *
+ * @return 0 on success, -1 on failure.
+ */
+int detect_numa_topology(numa_topology& topology);
+
+/** Allocates zeroed memory placed according to the NUMA mode.
+ *
+ * The pages are not populated, they are placed when they are first touched.
+ *
+ * @param size     Size of the data, returned by get_size() of the buffer.
+ * @param padding  Count of bytes after the end of the data.
+ * @param pages    Size of pages backing the memory.
+ * @param mode     numa_mode::local binds the memory to @p node,
+ *                 numa_mode::interleave interleaves it over all nodes of @p topology.
+ * @param node     Node of the local memory.
+ * @param topology NUMA topology.
+ * @param buffer   Output buffer.
+ *
+ * @return 0 on success, -1 on failure.
+ */
+int allocate_numa_buffer(
+		size_t               size,
+		size_t               padding,
+		page_mode            pages,
+		numa_mode            mode,
+		uint32_t             node,
+		const numa_topology& topology,
+		input_buffer&        buffer);
+
+/** Copies a buffer to new memory placed according to the NUMA mode.
+ *
+ * @param source   Buffer to copy.
+ * @param padding  Count of zeroed bytes after the end of the data.
+ * @param pages    Size of pages backing the copy.
+ * @param mode     numa_mode::local binds the copy to @p node,
+ *                 numa_mode::interleave interleaves it over all nodes of @p topology.
+ * @param node     Node of the local copy.
+ * @param topology NUMA topology.
+ * @param copy     Output buffer.
+ *
+ * @return 0 on success, -1 on failure.
+ */
+int create_numa_copy(
+		const input_buffer&  source,
+		size_t               padding,
+		page_mode            pages,
+		numa_mode            mode,
+		uint32_t             node,
+		const numa_topology& topology,
+		input_buffer&        copy);
+
+/** Allocates zeroed memory placed on a node.
+ *
+ * Kernels without NUMA support are tolerated, the memory is then placed on
+ * the only node there is.
+ *
+ * @param size        Count of bytes to allocate.
+ * @param node        Preferred node.
+ * @param mapped_size Output for the length of the mapping, which has to be
+ *                    passed to munmap().
+ *
+ * @return Address of the memory or nullptr on failure.
+ */
+void* allocate_on_node(size_t size, uint32_t node, size_t& mapped_size);
+
+/// Returns node of the page at @p address or -1 if it is not known.
+int get_memory_node(const void* address);
+
+#endif /* end of include guard: _NUMA_PLACEMENT_H_ */
@@ -0,0 +1,144 @@
+#include "perf_counters.h"
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <string.h>
+
+struct perf_counter_desc
+{
+	const char* name;
+
+	uint32_t    type;
+
+	uint64_t    config;
+};
+
+static constexpr uint64_t get_cache_config(const uint64_t cache)
+{
+	return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+static const perf_counter_desc PERF_COUNTERS[PERF_COUNTER_COUNT] =
+{
+	{ "cycles",         PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES                      },
+	{ "instructions",   PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS                    },
+	{ "l1d_misses",     PERF_TYPE_HW_CACHE, get_cache_config(PERF_COUNT_HW_CACHE_L1D)     },
+	{ "llc_misses",     PERF_TYPE_HW_CACHE, get_cache_config(PERF_COUNT_HW_CACHE_LL)      },
+	{ "dtlb_misses",    PERF_TYPE_HW_CACHE, get_cache_config(PERF_COUNT_HW_CACHE_DTLB)    },
+	{ "stalled_cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_STALLED_CYCLES_BACKEND          },
+};
+
+// Values read from a counter opened with PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING.
+struct perf_read_format
+{
+	uint64_t value;
+
+	uint64_t time_enabled;
+
+	uint64_t time_running;
+};
+
+perf_counter_values& perf_counter_values::operator+=(const perf_counter_values& rhs)
+{
+	for (uint32_t i = 0; i < PERF_COUNTER_COUNT; ++i)
+	{
+		values[i] += rhs.values[i];
+	}
+	available &= rhs.available;
+	return *this;
+}
+
+perf_counters::perf_counters()
+{
+	for (int& fd : fds)
+	{
+		fd = -1;
+	}
+}
+
+perf_counters::~perf_counters()
+{
+	for (const int fd : fds)
+	{
+		if (fd >= 0)
+		{
+			close(fd);
+		}
+	}
+}
+
+uint32_t perf_counters::open()
+{
+	uint32_t opened = 0;
+	for (uint32_t i = 0; i < PERF_COUNTER_COUNT; ++i)
+	{
+		struct perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = PERF_COUNTERS[i].type;
+		attr.config = PERF_COUNTERS[i].config;
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+		// There is no glibc wrapper of perf_event_open().
+		fds[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+		if (fds[i] >= 0)
+		{
+			opened++;
+		}
+	}
+	return opened;
+}
+
+void perf_counters::start()
+{
+	for (const int fd : fds)
+	{
+		if (fd >= 0)
+		{
+			ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+			ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+		}
+	}
+}
+
+void perf_counters::stop()
+{
+	for (const int fd : fds)
+	{
+		if (fd >= 0)
+		{
+			ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+		}
+	}
+}
+
+perf_counter_values perf_counters::read() const
+{
+	perf_counter_values counters;
+	for (uint32_t i = 0; i < PERF_COUNTER_COUNT; ++i)
+	{
+		perf_read_format data;
+		if (fds[i] < 0 || ::read(fds[i], &data, sizeof(data)) != sizeof(data) || !data.time_running)
+		{
+			continue;
+		}
+		counters.values[i] = data.value;
+		if (data.time_running < data.time_enabled)
+		{
+			// The counter was multiplexed with other events, extrapolate to the whole time.
+			counters.values[i] = (uint64_t)((double)data.value * data.time_enabled / data.time_running);
+		}
+		counters.available |= 1u << i;
+	}
+	return counters;
+}
+
+const char* get_perf_counter_name(const perf_counter counter)
+{
+	return counter < PERF_COUNTER_COUNT ? PERF_COUNTERS[counter].name : "unknown";
+}
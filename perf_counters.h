@@ -0,0 +1,68 @@
+#ifndef _PERF_COUNTERS_H_
+#define _PERF_COUNTERS_H_
+
+#include <stdint.h>
+
+/// Hardware events counted by perf_counters.
+enum perf_counter : uint32_t
+{
+	PERF_COUNTER_CYCLES,
+	PERF_COUNTER_INSTRUCTIONS,
+	PERF_COUNTER_L1D_MISSES,
+	PERF_COUNTER_LLC_MISSES,
+	PERF_COUNTER_DTLB_MISSES,
+	/// Cycles stalled in the backend, mostly waiting for memory.
+	PERF_COUNTER_STALLED_CYCLES,
+	PERF_COUNTER_COUNT,
+};
+
+/// Values of the counters, values[i] is valid only if bit i of available is set.
+struct perf_counter_values
+{
+	uint64_t values[PERF_COUNTER_COUNT] = {};
+
+	uint32_t available = 0;
+
+	/// Adds the counters available in both.
+	perf_counter_values& operator+=(const perf_counter_values& rhs);
+};
+
+/** Per-thread hardware counters opened by perf_event_open().
+ *
+ * Each counter is opened on its own, so the counters the CPU or the kernel
+ * does not support (or perf_event_paranoid forbids) are just unavailable.
+ * Only user space is counted. Values are scaled when the kernel multiplexes
+ * the counters.
+ */
+class perf_counters
+{
+public:
+	perf_counters();
+
+	~perf_counters();
+
+	/** Opens the counters of the calling thread, disabled.
+	 *
+	 * @return Count of counters opened.
+	 */
+	uint32_t open();
+
+	/// Resets and enables all opened counters.
+	void start();
+
+	/// Disables all opened counters.
+	void stop();
+
+	perf_counter_values read() const;
+
+private:
+	int fds[PERF_COUNTER_COUNT];
+
+	// No copying.
+	perf_counters( const perf_counters& )            = delete;
+	perf_counters& operator=( const perf_counters& ) = delete;
+};
+
+const char* get_perf_counter_name(perf_counter counter);
+
+#endif /* end of include guard: _PERF_COUNTERS_H_ */
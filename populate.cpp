@@ -0,0 +1,179 @@
+#include "populate.h"
+#include "bench_common.h"
+#include "common.h"
+#include "file_loader.h"
+#include "scope_guard.h"
+
+#include <sys/resource.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+
+constexpr uint32_t POPULATE_THREADS_MAX = 1024;
+
+/// Work shared by the populating threads.
+struct populate_data
+{
+	int               fd;
+
+	const char*       path;
+
+	uint64_t          file_offset;
+
+	uint8_t*          data;
+
+	size_t            size;
+
+	populate_mode     mode;
+
+	size_t            unit;
+
+	uint32_t          thread_count;
+
+	std::atomic<bool> failed{false};
+};
+
+struct populate_thread
+{
+	populate_data* common;
+
+	uint32_t       id;
+};
+
+static int read_range(populate_data& populate, size_t offset, const size_t end)
+{
+	while (offset < end)
+	{
+		const size_t  length = std::min(end - offset, FILE_LOAD_CHUNK_SIZE);
+		const ssize_t result = pread(populate.fd, populate.data + offset, length, populate.file_offset + offset);
+		if (result < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if (result <= 0)
+		{
+			ERR("read of %s at offset %zu failed\n", populate.path, offset);
+			populate.failed = true;
+			return -1;
+		}
+		offset += result;
+	}
+	return 0;
+}
+
+static void* populate_thread_func(void* arg)
+{
+	const populate_thread& thread = *(const populate_thread*)arg;
+	populate_data&         populate = *thread.common;
+
+	pin_thread(thread.id);
+
+	const size_t unit_count = (populate.size + populate.unit - 1) / populate.unit;
+	if (populate.mode == populate_mode::partition)
+	{
+		const size_t first = unit_count * thread.id / populate.thread_count;
+		const size_t last = unit_count * (thread.id + 1) / populate.thread_count;
+		read_range(populate, std::min(first * populate.unit, populate.size), std::min(last * populate.unit, populate.size));
+		return nullptr;
+	}
+
+	for (size_t unit = thread.id; unit < unit_count && !populate.failed; unit += populate.thread_count)
+	{
+		if (read_range(populate, unit * populate.unit, std::min((unit + 1) * populate.unit, populate.size)) < 0)
+		{
+			break;
+		}
+	}
+	return nullptr;
+}
+
+static uint64_t get_page_faults(bool major)
+{
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return major ? usage.ru_majflt : usage.ru_minflt;
+}
+
+int populate_input_buffer(
+		const char*     location,
+		const char*     filename,
+		populate_mode   mode,
+		size_t          unit,
+		uint32_t        thread_count,
+		input_buffer&   buffer,
+		file_payload&   payload,
+		populate_stats& stats)
+{
+	if (mode == populate_mode::none || unit == 0 || thread_count == 0 || thread_count > POPULATE_THREADS_MAX)
+	{
+		ERR("invalid population of %s\n", filename);
+		return -1;
+	}
+
+	char path[FILE_PATH_MAX];
+	if (get_data_file_path(path, sizeof(path), location, filename) < 0)
+	{
+		return -1;
+	}
+	const int fd = open(path, O_RDONLY);
+	if (fd < 0)
+	{
+		ERR("open(%s) failed\n", path);
+		return -1;
+	}
+	auto close_fd = scope_exit([&]() { close(fd); });
+	if (read_file_header(fd, path, payload) < 0)
+	{
+		return -1;
+	}
+	if (payload.size < buffer.get_size())
+	{
+		ERR("size of %s %s is lower then expected %zu\n", payload.has_header ? "payload of" : "file", path, buffer.get_size());
+		return -1;
+	}
+
+	populate_data populate;
+	populate.fd = fd;
+	populate.path = path;
+	populate.file_offset = payload.offset;
+	populate.data = buffer.get<uint8_t>();
+	populate.size = buffer.get_size();
+	populate.mode = mode;
+	populate.unit = unit;
+	populate.thread_count = thread_count;
+
+	const uint64_t  minor_faults = get_page_faults(false);
+	const uint64_t  major_faults = get_page_faults(true);
+	struct timespec start;
+	struct timespec end;
+	clock_gettime(CLOCK_MONOTONIC_RAW, &start);
+
+	pthread_t       threads[POPULATE_THREADS_MAX];
+	populate_thread thread_args[POPULATE_THREADS_MAX];
+	uint32_t        started = 0;
+	for (; started < thread_count; ++started)
+	{
+		thread_args[started].common = &populate;
+		thread_args[started].id = started;
+		if (pthread_create(&threads[started], nullptr, populate_thread_func, &thread_args[started]) != 0)
+		{
+			ERR("pthread_create failed for populating thread %u\n", started);
+			populate.failed = true;
+			break;
+		}
+	}
+	for (uint32_t i = 0; i < started; ++i)
+	{
+		pthread_join(threads[i], nullptr);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC_RAW, &end);
+	stats.time = get_clockdiff_ms(&start, &end);
+	stats.minor_faults = get_page_faults(false) - minor_faults;
+	stats.major_faults = get_page_faults(true) - major_faults;
+	return populate.failed ? -1 : 0;
+}
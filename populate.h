@@ -0,0 +1,61 @@
+#ifndef _POPULATE_H_
+#define _POPULATE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "input_buffer.h"
+
+/// How the pages of a buffer are divided among the populating threads.
+enum class populate_mode : uint32_t
+{
+	/// The buffer is filled by the loading thread.
+	none,
+	/// Units of the buffer go round robin to the threads.
+	interleave,
+	/// Each thread gets one contiguous part of the buffer.
+	partition,
+};
+
+struct populate_stats
+{
+	/// Wall time of the population in ms.
+	double   time = 0.0;
+
+	/// Page faults served without I/O.
+	uint64_t minor_faults = 0;
+
+	/// Page faults which needed I/O.
+	uint64_t major_faults = 0;
+};
+
+/** Fills a buffer with the payload of a file by threads pinned to CPUs.
+ *
+ * Thread i runs on CPU i and is the first to touch the pages of its units,
+ * so the pages are faulted by all threads in parallel and placed on the
+ * nodes of the threads which use them.
+ *
+ * @param location     Directory with the file.
+ * @param filename     Name of the file.
+ * @param mode         Division of the buffer, not populate_mode::none.
+ * @param unit         Size of the units the buffer is divided into, a multiple
+ *                     of the size of the pages backing the buffer.
+ * @param thread_count Count of threads, CPUs 0 to thread_count - 1 are used.
+ * @param buffer       Buffer mapped by mmap() and not populated yet,
+ *                     get_size() bytes are loaded to it.
+ * @param payload      Output with the header and the location of the payload.
+ * @param stats        Output for the time and page faults of the population.
+ *
+ * @return 0 on success, -1 on failure.
+ */
+int populate_input_buffer(
+		const char*     location,
+		const char*     filename,
+		populate_mode   mode,
+		size_t          unit,
+		uint32_t        thread_count,
+		input_buffer&   buffer,
+		file_payload&   payload,
+		populate_stats& stats);
+
+#endif /* end of include guard: _POPULATE_H_ */
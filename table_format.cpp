@@ -0,0 +1,85 @@
+#include "table_format.h"
+
+uint32_t get_table_element_bits(table_format format)
+{
+	switch (format)
+	{
+		case table_format::u8:
+			return 8;
+
+		case table_format::u12:
+			return 12;
+
+		case table_format::u16:
+			return 16;
+
+		case table_format::u32:
+			return 32;
+	}
+	return 0;
+}
+
+size_t get_table_size(table_format format, size_t count_of_elements)
+{
+	return (count_of_elements * get_table_element_bits(format) + 7) / 8;
+}
+
+const char* get_table_file_name(table_format format)
+{
+	switch (format)
+	{
+		case table_format::u8:
+			return "table_u8.bin";
+
+		case table_format::u12:
+			return "table_u12.bin";
+
+		case table_format::u16:
+			return "table.bin";
+
+		case table_format::u32:
+			return "table_u32.bin";
+	}
+	return nullptr;
+}
+
+void convert_table(const uint16_t* source, size_t count_of_elements, table_format format, void* destination)
+{
+	switch (format)
+	{
+		case table_format::u8:
+			for (size_t i = 0; i < count_of_elements; ++i)
+			{
+				((uint8_t*)destination)[i] = (uint8_t)source[i];
+			}
+			break;
+
+		case table_format::u12:
+		{
+			uint8_t* const packed = (uint8_t*)destination;
+			for (size_t i = 0; i < count_of_elements; i += 2)
+			{
+				const uint32_t even = source[i] & 0xFFF;
+				const uint32_t odd = (i + 1 < count_of_elements) ? source[i + 1] & 0xFFF : 0;
+				packed[i / 2 * 3    ] = (uint8_t)even;
+				packed[i / 2 * 3 + 1] = (uint8_t)((even >> 8) | (odd << 4));
+				if (i + 1 < count_of_elements)
+				{
+					packed[i / 2 * 3 + 2] = (uint8_t)(odd >> 4);
+				}
+			}
+			break;
+		}
+
+		case table_format::u16:
+			memcpy(destination, source, count_of_elements * sizeof(uint16_t));
+			break;
+
+		case table_format::u32:
+			for (size_t i = 0; i < count_of_elements; ++i)
+			{
+				((uint32_t*)destination)[i] = source[i];
+			}
+			break;
+	}
+}
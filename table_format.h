@@ -0,0 +1,91 @@
+#ifndef _TABLE_FORMAT_H_
+#define _TABLE_FORMAT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/// Width of elements of the table.
+enum class table_format : uint32_t
+{
+	u8,
+	/// 12-bit elements packed by pairs to 3 bytes, little endian.
+	u12,
+	u16,
+	u32,
+};
+
+/// Count of bits of an element.
+uint32_t get_table_element_bits(table_format format);
+
+/// Count of bytes of a table with @p count_of_elements elements.
+size_t get_table_size(table_format format, size_t count_of_elements);
+
+/// Name of the file with the table in given format, table.bin holds u16 elements.
+const char* get_table_file_name(table_format format);
+
+/** Converts the u16 table to another format.
+ *
+ * Elements wider than the format are truncated.
+ *
+ * @param source            Table with u16 elements.
+ * @param count_of_elements Count of elements of the table.
+ * @param format            Format of the destination.
+ * @param destination       Buffer of get_table_size(format, count_of_elements) bytes.
+ */
+void convert_table(const uint16_t* source, size_t count_of_elements, table_format format, void* destination);
+
+/** Returns byte offset of a table element, the functions below are static, so
+ * every kernel translation unit gets its own copy compiled for its
+ * instruction set (see kernels.h).
+ */
+template<table_format FORMAT>
+static inline size_t get_table_element_offset(size_t index)
+{
+	if constexpr (FORMAT == table_format::u8)
+	{
+		return index;
+	}
+	else if constexpr (FORMAT == table_format::u12)
+	{
+		return index * 3 / 2;
+	}
+	else if constexpr (FORMAT == table_format::u16)
+	{
+		return index * 2;
+	}
+	else
+	{
+		return index * 4;
+	}
+}
+
+/** Loads element of a table.
+ *
+ * Packed 12-bit elements are read by an unaligned 16-bit load, which reads one
+ * byte past the last element, so the table has to be padded.
+ */
+template<table_format FORMAT>
+static inline uint32_t load_table_element(const void* table, size_t index)
+{
+	if constexpr (FORMAT == table_format::u8)
+	{
+		return ((const uint8_t*)table)[index];
+	}
+	else if constexpr (FORMAT == table_format::u12)
+	{
+		uint16_t packed;
+		memcpy(&packed, (const uint8_t*)table + get_table_element_offset<FORMAT>(index), sizeof(packed));
+		return (packed >> ((index & 1) * 4)) & 0xFFF;
+	}
+	else if constexpr (FORMAT == table_format::u16)
+	{
+		return ((const uint16_t*)table)[index];
+	}
+	else
+	{
+		return ((const uint32_t*)table)[index];
+	}
+}
+
+#endif /* end of include guard: _TABLE_FORMAT_H_ */
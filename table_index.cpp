@@ -0,0 +1,105 @@
+#include "table_index.h"
+#include "common.h"
+
+#include <inttypes.h>
+
+uint32_t get_table_index_shift(uint64_t count_of_elements)
+{
+	uint32_t shift = 0;
+	while ((count_of_elements >> shift) > ((uint64_t)1 << 32))
+	{
+		shift++;
+	}
+	return shift;
+}
+
+/// Computes the reciprocal of get_quotient() as libdivide_u32_branchfree_gen() does.
+static void init_divisor(uint32_t divisor, table_indexing& indexing)
+{
+	const uint32_t floor_log = 31 - __builtin_clz(divisor);
+	indexing.divisor = divisor;
+	if (!(divisor & (divisor - 1)))
+	{
+		indexing.magic = 0;
+		indexing.magic_shift = floor_log - 1;
+		return;
+	}
+
+	const uint64_t dividend = (uint64_t)1 << (32 + floor_log);
+	uint32_t       magic = (uint32_t)(dividend / divisor);
+	const uint64_t remainder = dividend % divisor;
+	magic += magic;
+	if (remainder * 2 >= divisor)
+	{
+		magic++;
+	}
+	indexing.magic = magic + 1;
+	indexing.magic_shift = floor_log;
+}
+
+int init_table_indexing(table_reduction reduction, uint64_t count_of_elements, table_indexing& indexing)
+{
+	indexing = table_indexing();
+	indexing.reduction = reduction;
+	indexing.count = count_of_elements;
+	switch (reduction)
+	{
+		case table_reduction::mask:
+			if (!count_of_elements || (count_of_elements & (count_of_elements - 1)))
+			{
+				ERR("mask reduction needs a power of two count of table elements, not %" PRIu64 "\n", count_of_elements);
+				return -1;
+			}
+			indexing.mask = count_of_elements - 1;
+			indexing.shift = get_table_index_shift(count_of_elements);
+			return 0;
+
+		case table_reduction::multiply:
+			if (!count_of_elements)
+			{
+				ERR("multiply reduction needs a table\n");
+				return -1;
+			}
+			return 0;
+
+		case table_reduction::divide:
+			if (count_of_elements < 2)
+			{
+				ERR("divide reduction needs at least 2 table elements\n");
+				return -1;
+			}
+			while ((count_of_elements >> indexing.shift) > UINT32_MAX)
+			{
+				indexing.shift++;
+			}
+			init_divisor((uint32_t)(count_of_elements >> indexing.shift), indexing);
+			return 0;
+	}
+	return -1;
+}
+
+uint64_t get_table_slot_count(const table_indexing& indexing)
+{
+	switch (indexing.reduction)
+	{
+		case table_reduction::mask:
+			return indexing.count >> indexing.shift;
+
+		case table_reduction::multiply:
+			return indexing.count < ((uint64_t)1 << 32) ? indexing.count : ((uint64_t)1 << 32);
+
+		case table_reduction::divide:
+			return indexing.divisor;
+	}
+	return 0;
+}
+
+uint32_t get_slot_index(const table_indexing& indexing, uint64_t slot)
+{
+	if (indexing.reduction == table_reduction::multiply && indexing.count <= ((uint64_t)1 << 32))
+	{
+		// The smallest index whose product with the count reaches the slot.
+		return (uint32_t)(((slot << 32) + indexing.count - 1) / indexing.count);
+	}
+	return (uint32_t)slot;
+}
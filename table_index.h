@@ -0,0 +1,127 @@
+#ifndef _TABLE_INDEX_H_
+#define _TABLE_INDEX_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// Reduction of the 32-bit indices to the range of the table elements.
+enum class table_reduction : uint32_t
+{
+	/// index & (count - 1), tables of a power of two elements only.
+	mask,
+	/// Lemire's multiply-shift (index * count) >> 32, the index range is scaled to the table.
+	multiply,
+	/// index % count, the division by the constant count is a multiplication by its reciprocal.
+	divide,
+};
+
+/** Parameters of the reduction of the indices to a table.
+ *
+ * Kernels copy it to a local, so the parameters stay in registers while the
+ * indices are stored.
+ */
+struct table_indexing
+{
+	table_reduction reduction;
+
+	/// Count of elements of the table.
+	uint64_t        count;
+
+	/// count - 1 of the mask reduction.
+	uint64_t        mask;
+
+	/// Count of bits the mask and divide reductions shift the indices by to reach tables with more than 2^32 elements.
+	uint32_t        shift;
+
+	/// Divisor of the divide reduction, count of the table elements reached without the shift.
+	uint32_t        divisor;
+
+	/// Reciprocal of the divisor, see get_quotient().
+	uint32_t        magic;
+
+	uint32_t        magic_shift;
+};
+
+/** Prepares the reduction of indices to a table.
+ *
+ * @param reduction         Reduction, mask needs a power of two count of elements.
+ * @param count_of_elements Count of elements of the table.
+ * @param indexing          Output parameters.
+ *
+ * @return 0 on success, -1 if the reduction cannot serve the table.
+ */
+int init_table_indexing(table_reduction reduction, uint64_t count_of_elements, table_indexing& indexing);
+
+/// Returns the table_indexing::shift spreading the 32-bit indices over a table with @p count_of_elements elements.
+uint32_t get_table_index_shift(uint64_t count_of_elements);
+
+/// Count of the distinct table elements the 32-bit indices are reduced to, see get_slot_index().
+uint64_t get_table_slot_count(const table_indexing& indexing);
+
+/** Returns an index which is reduced to slot @p slot of the table.
+ *
+ * Slots are the table elements reached by the 32-bit indices, the elements
+ * of tables with more than 2^32 elements are reached only by some indices.
+ */
+uint32_t get_slot_index(const table_indexing& indexing, uint64_t slot);
+
+/** Divides by the divisor of the divide reduction.
+ *
+ * The branchfree algorithm of libdivide, exact for all 32-bit numerators and
+ * divisors of at least 2. Static as the functions of table_format.h.
+ */
+static inline uint32_t get_quotient(uint32_t index, const table_indexing& indexing)
+{
+	const uint32_t high = (uint32_t)(((uint64_t)index * indexing.magic) >> 32);
+	return (((index - high) >> 1) + high) >> indexing.magic_shift;
+}
+
+/** Returns the index of the table element looked up by a 32-bit index.
+ *
+ * TABLE_INDEX is uint32_t unless the table needs wide indices, then the mask
+ * and divide reductions shift the reduced index to reach tables with more than
+ * 2^32 elements, which get every (1 << shift)-th element looked up. The
+ * multiply reduction scales the indices to the whole count.
+ */
+template<table_reduction REDUCTION, typename TABLE_INDEX>
+static inline TABLE_INDEX get_table_index(uint32_t index, const table_indexing& indexing)
+{
+	constexpr bool narrow = sizeof(TABLE_INDEX) == sizeof(uint32_t);
+	if constexpr (REDUCTION == table_reduction::mask)
+	{
+		if constexpr (narrow)
+		{
+			return index & (TABLE_INDEX)indexing.mask;
+		}
+		else
+		{
+			return ((TABLE_INDEX)index << indexing.shift) & indexing.mask;
+		}
+	}
+	else if constexpr (REDUCTION == table_reduction::multiply)
+	{
+		if constexpr (narrow)
+		{
+			return (TABLE_INDEX)(((uint64_t)index * indexing.count) >> 32);
+		}
+		else
+		{
+			// The product does not fit 64 bits, the low and high words of the count are multiplied apart.
+			return (TABLE_INDEX)index * (indexing.count >> 32) + (((TABLE_INDEX)index * (uint32_t)indexing.count) >> 32);
+		}
+	}
+	else
+	{
+		const uint32_t remainder = index - get_quotient(index, indexing) * indexing.divisor;
+		if constexpr (narrow)
+		{
+			return remainder;
+		}
+		else
+		{
+			return (TABLE_INDEX)remainder << indexing.shift;
+		}
+	}
+}
+
+#endif /* end of include guard: _TABLE_INDEX_H_ */